@@ -0,0 +1,25 @@
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <iostream>
+
+void BenchmarkRunner::AddResult(const std::string &name, nlohmann::ordered_json &&parameters,
+                                unsigned long long iterationCount, std::vector<double> &&sampleTimes) {
+    assert(!sampleTimes.empty());
+    std::vector<double> nsPerIteration;
+    for (auto time : sampleTimes)
+        nsPerIteration.push_back(time * 1e9 / iterationCount);
+    std::sort(nsPerIteration.begin(), nsPerIteration.end());
+    auto middle = nsPerIteration.size() / 2;
+    auto median = nsPerIteration.size() % 2 ? nsPerIteration[middle]
+                                            : (nsPerIteration[middle - 1] + nsPerIteration[middle]) / 2;
+    if (ShowProgress)
+        std::cout << std::left << std::setw(32) << name << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(1) << median << " ns  " << parameters.dump() << std::endl;
+    m_Results.push_back({{"name", name},
+                         {"parameters", std::move(parameters)},
+                         {"iterations", iterationCount},
+                         {"ns_per_iteration",
+                          {{"median", median}, {"min", nsPerIteration.front()}, {"max", nsPerIteration.back()}}}});
+}
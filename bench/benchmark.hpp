@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Times operations in samples of enough iterations to last the minimum sample time, and collects the time per
+// iteration of every benchmark as JSON, so that the results of different commits can be compared.
+class BenchmarkRunner {
+private:
+    nlohmann::ordered_json m_Results = nlohmann::ordered_json::array();
+    // Written with the results of the operations, so that they are not optimized away
+    static inline volatile std::size_t s_Sink = 0;
+
+    void AddResult(const std::string &name, nlohmann::ordered_json &&parameters, unsigned long long iterationCount,
+                   std::vector<double> &&sampleTimes);
+
+public:
+    // Only the benchmarks whose names contain the filter are run.
+    std::string Filter;
+    double MinSampleTime = 0.05; // In second
+    unsigned int SampleCount = 5;
+    bool ShowProgress = true;
+
+    bool IsSelected(const std::string &name) const { return name.find(Filter) != std::string::npos; }
+    // Returns whether any of the benchmarks is selected, so that the setup shared by them can be skipped otherwise.
+    bool IsAnySelected(std::initializer_list<const char *> names) const {
+        return std::any_of(names.begin(), names.end(), [this](const char *name) { return IsSelected(name); });
+    }
+    // Runs the benchmark of the name and the parameters if it is selected. Each iteration calls the operation once,
+    // which returns a value depending on its work.
+    template <typename TOperation>
+    void Run(const std::string &name, nlohmann::ordered_json parameters, TOperation &&operation);
+    // Returns the name, the parameters, the iteration count of each sample and the nanoseconds per iteration of every
+    // benchmark run.
+    const nlohmann::ordered_json &GetResults() const { return m_Results; }
+};
+
+template <typename TOperation>
+void BenchmarkRunner::Run(const std::string &name, nlohmann::ordered_json parameters, TOperation &&operation) {
+    if (!IsSelected(name))
+        return;
+    auto timeSample = [&operation](unsigned long long iterationCount) {
+        std::size_t sink = 0;
+        auto startTime = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < iterationCount; ++i)
+            sink += operation();
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+        s_Sink = sink;
+        return duration.count();
+    };
+    // The first samples also warm up the caches
+    unsigned long long iterationCount = 1;
+    for (auto time = timeSample(iterationCount); time < MinSampleTime; time = timeSample(iterationCount))
+        iterationCount *= time * 10 < MinSampleTime ? 10 : 2;
+    std::vector<double> sampleTimes;
+    for (unsigned int i = 0; i < SampleCount; ++i)
+        sampleTimes.push_back(timeSample(iterationCount));
+    AddResult(name, std::move(parameters), iterationCount, std::move(sampleTimes));
+}
+
+// Runs the benchmarks of the topology, the host allocation policies, the MIS solvers and the jobs on fat trees of the
+// degrees.
+void RunKernelBenchmarks(BenchmarkRunner &runner, const std::vector<unsigned int> &degrees);
+
+// Runs the full simulations of the scenarios whose names contain the filter, each the fastest of the repetitions, and
+// returns the wall time of each phase, the events per second, the peak resident set size in bytes and the result of
+// each.
+nlohmann::ordered_json RunScenarios(const std::string &filter, unsigned int repetitionCount);
+// Compares the scenarios returned by RunScenarios with those of a baseline file and returns the status of each. A
+// scenario regresses if its events per second fall below the baseline by more than the throughput tolerance, if its
+// settings changed, or if any field of its result other than the times of the policies differs by more than the
+// relative metric tolerance. Sets isRegressed if any does.
+nlohmann::ordered_json CompareScenarios(const nlohmann::ordered_json &scenarios, const nlohmann::ordered_json &baseline,
+                                        double throughputTolerance, double metricTolerance, bool &isRegressed);
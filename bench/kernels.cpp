@@ -0,0 +1,266 @@
+#include "benchmark.hpp"
+#include "data.hpp"
+#include "fat_tree.hpp"
+#include "fat_tree_resource.hpp"
+#include "host_allocation_policies/first.hpp"
+#include "host_allocation_policies/random.hpp"
+#include "host_allocation_policies/smart.hpp"
+#include "job.hpp"
+#include "simulation_context.hpp"
+#include "utils/mis_solver.hpp"
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+
+// The sizes of the jobs: rack jobs fit under one edge switch, pod jobs fit in one pod but not under one edge switch,
+// multi-pod jobs span pods with up to half of the hosts, and mixed jobs are of any of them.
+static const std::vector<std::string> JobSizeMixes = {"rack", "pod", "multi_pod", "mixed"};
+// The fractions of the hosts in use when the host allocation policies are called
+static const std::vector<double> Occupancies = {0.0, 0.5, 0.9};
+// The number of inputs of a benchmark, which its iterations cycle through
+static constexpr unsigned int PoolSize = 64;
+static constexpr unsigned int Seed = 42;
+// The number of roots sampled for each job when building conflict graphs, as in the experiments
+static constexpr unsigned int MaxTreeCount = 5;
+
+static unsigned int DrawHostCount(const std::string &mix, unsigned int degree, PhiloxEngine &engine) {
+    auto rackSize = degree / 2, podSize = degree * degree / 4, maxSize = degree * degree * degree / 8;
+    const std::array<std::pair<unsigned int, unsigned int>, 3> ranges = {
+        {{1, rackSize}, {rackSize + 1, podSize}, {podSize + 1, maxSize}}};
+    auto mixIdx = std::find(JobSizeMixes.cbegin(), JobSizeMixes.cend(), mix) - JobSizeMixes.cbegin();
+    auto [minSize, maxSizeOfMix] = ranges[mixIdx < 3 ? mixIdx : std::uniform_int_distribution<>(0, 2)(engine)];
+    return std::uniform_int_distribution<unsigned int>(minSize, maxSizeOfMix)(engine);
+}
+
+static std::unique_ptr<Job> CreateJob(unsigned int hostCount, unsigned int id) {
+    std::vector<CommOpGroup> commOpGroups = {{{CommOp(0.0, 1'000'000, CommOp::Type::AllReduce)}, 0.0}};
+    auto job = std::make_unique<Job>(hostCount, std::nullopt, std::move(commOpGroups),
+                                     DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    job->ID = id;
+    return job;
+}
+
+// Fills the cluster with jobs of the mix placed by the first host allocation policy, then removes random jobs until
+// at most the occupancy of the hosts is in use, which leaves the fragmentation of a cluster where jobs come and go.
+// Returns the jobs left, whose hosts are allocated on the resources.
+static std::vector<std::unique_ptr<Job>> PlaceJobs(FatTreeResource &resources, const std::string &mix,
+                                                   double occupancy) {
+    auto degree = resources.Topology->DownLinkCount[0] * 2;
+    auto hostCount = resources.Topology->NodesByLayer[0].size();
+    SimulationContext context;
+    auto engine = CreateRandomEngine(Seed, RandomSubsystem::Workload, 0);
+    std::vector<std::unique_ptr<Job>> jobs;
+    unsigned int usedHostCount = 0;
+    for (unsigned int failureCount = 0; failureCount < 16;) {
+        auto job = CreateJob(DrawHostCount(mix, degree, engine), context.NextJobID++);
+        auto hosts = FirstHostAllocationPolicy()(resources, *job, context);
+        if (!hosts) {
+            ++failureCount;
+            continue;
+        }
+        failureCount = 0;
+        resources.Allocate(*hosts);
+        job->SetHosts(std::move(*hosts));
+        usedHostCount += job->HostCount;
+        jobs.push_back(std::move(job));
+    }
+    std::shuffle(jobs.begin(), jobs.end(), engine);
+    while (!jobs.empty() && usedHostCount > occupancy * hostCount) {
+        resources.Deallocate(jobs.back()->GetHosts());
+        usedHostCount -= jobs.back()->HostCount;
+        jobs.pop_back();
+    }
+    return jobs;
+}
+
+// Returns the aggregation tree of each job from a root drawn from its closest common ancestors.
+static std::vector<FatTree::AggrTree> BuildAggrTrees(const FatTree &topology,
+                                                     const std::vector<std::unique_ptr<Job>> &jobs) {
+    auto engine = CreateRandomEngine(Seed, RandomSubsystem::TreeBuilding, 0);
+    std::vector<FatTree::AggrTree> aggrTrees;
+    for (const auto &job : jobs) {
+        auto roots = topology.GetClosestCommonAncestors(job->GetHosts());
+        auto root = roots[std::uniform_int_distribution<std::size_t>(0, roots.size() - 1)(engine)];
+        aggrTrees.push_back(topology.GetAggregationTree(job->GetHosts(), root));
+    }
+    return aggrTrees;
+}
+
+static void RunTopologyBenchmarks(BenchmarkRunner &runner, const FatTree &topology, const std::string &mix) {
+    unsigned int degree = topology.DownLinkCount[0] * 2;
+    FatTreeResource resources(topology, 1, 1);
+    auto jobs = PlaceJobs(resources, mix, 1.0);
+    jobs.resize(std::min<std::size_t>(jobs.size(), PoolSize));
+    unsigned int jobIdx = 0;
+    runner.Run("get_closest_common_ancestors", {{"degree", degree}, {"mix", mix}}, [&]() {
+        const auto &job = *jobs[jobIdx++ % jobs.size()];
+        return topology.GetClosestCommonAncestors(job.GetHosts()).size();
+    });
+    std::vector<std::pair<const Job *, const FatTree::Node *>> treeInputs;
+    for (const auto &job : jobs)
+        treeInputs.emplace_back(job.get(), topology.GetClosestCommonAncestors(job->GetHosts()).front());
+    jobIdx = 0;
+    runner.Run("get_aggregation_tree", {{"degree", degree}, {"mix", mix}}, [&]() {
+        auto [job, root] = treeInputs[jobIdx++ % treeInputs.size()];
+        return topology.GetAggregationTree(job->GetHosts(), root).second.size();
+    });
+}
+
+static void RunTreeConflictBenchmarks(BenchmarkRunner &runner, const FatTree &topology, const std::string &mix) {
+    unsigned int degree = topology.DownLinkCount[0] * 2;
+    FatTreeResource resources(topology, 1, 1);
+    auto jobs = PlaceJobs(resources, mix, 1.0);
+    auto aggrTrees = BuildAggrTrees(topology, jobs);
+    // The usage is that of the trees allocated in order while they do not conflict, and the queries are the trees of
+    // the first jobs, some of which are allocated
+    for (const auto &aggrTree : aggrTrees)
+        if (!resources.CheckTreeConflict(aggrTree))
+            resources.Allocate(aggrTree);
+    aggrTrees.resize(std::min<std::size_t>(aggrTrees.size(), PoolSize));
+    std::vector<CompactAggrTree> compactAggrTrees(aggrTrees.cbegin(), aggrTrees.cend());
+    auto runForm = [&](const char *form, const auto &trees) {
+        unsigned int treeIdx = 0;
+        runner.Run("check_tree_conflict_usage", {{"degree", degree}, {"mix", mix}, {"form", form}}, [&]() {
+            return static_cast<std::size_t>(resources.CheckTreeConflict(trees[treeIdx++ % trees.size()]));
+        });
+        treeIdx = 0;
+        runner.Run("check_tree_conflict_pair", {{"degree", degree}, {"mix", mix}, {"form", form}}, [&]() {
+            const auto &tree1 = trees[treeIdx++ % trees.size()];
+            const auto &tree2 = trees[treeIdx % trees.size()];
+            return static_cast<std::size_t>(resources.CheckTreeConflict(tree1, tree2));
+        });
+    };
+    runForm("aggr_tree", aggrTrees);
+    runForm("compact", compactAggrTrees);
+}
+
+static void RunHostAllocationBenchmarks(BenchmarkRunner &runner, const FatTree &topology, const std::string &mix) {
+    unsigned int degree = topology.DownLinkCount[0] * 2;
+    for (auto occupancy : Occupancies) {
+        FatTreeResource resources(topology, 1, 1);
+        auto placedJobs = PlaceJobs(resources, mix, occupancy);
+        SimulationContext context;
+        context.NextJobID = placedJobs.size();
+        auto engine = CreateRandomEngine(Seed, RandomSubsystem::Workload, 1);
+        std::vector<std::unique_ptr<Job>> jobs;
+        for (unsigned int i = 0; i < PoolSize; ++i)
+            jobs.push_back(CreateJob(DrawHostCount(mix, degree, engine), context.NextJobID++));
+        auto runPolicy = [&](const char *policyName, const auto &policy) {
+            unsigned int jobIdx = 0;
+            runner.Run("host_allocation",
+                       {{"degree", degree}, {"mix", mix}, {"policy", policyName}, {"occupancy", occupancy}}, [&]() {
+                           auto hosts = policy(resources, *jobs[jobIdx++ % jobs.size()], context);
+                           return hosts ? hosts->size() : 0;
+                       });
+        };
+        runPolicy("first", FirstHostAllocationPolicy());
+        runPolicy("smart", SmartHostAllocationPolicy(0.5));
+        runPolicy("random", RandomHostAllocationPolicy());
+    }
+}
+
+// Builds the conflict graph that the smart tree building policy solves for the jobs of a full cluster: a node for
+// each of up to 5 trees of a job, and an edge between the trees of the same job and between conflicting trees.
+static void RunMisSolverBenchmarks(BenchmarkRunner &runner, const FatTree &topology, const std::string &mix) {
+    unsigned int degree = topology.DownLinkCount[0] * 2;
+    FatTreeResource resources(topology, 1, 1);
+    auto jobs = PlaceJobs(resources, mix, 1.0);
+    auto engine = CreateRandomEngine(Seed, RandomSubsystem::TreeBuilding, 0);
+    std::vector<FatTree::AggrTree> aggrTrees;
+    std::vector<unsigned int> treeIdxToJobIdx;
+    for (unsigned int jobIdx = 0; jobIdx < jobs.size(); ++jobIdx) {
+        auto roots = topology.GetClosestCommonAncestors(jobs[jobIdx]->GetHosts());
+        std::vector<const FatTree::Node *> chosenRoots;
+        std::sample(roots.cbegin(), roots.cend(), std::back_inserter(chosenRoots), MaxTreeCount, engine);
+        for (auto root : chosenRoots) {
+            aggrTrees.push_back(topology.GetAggregationTree(jobs[jobIdx]->GetHosts(), root));
+            treeIdxToJobIdx.push_back(jobIdx);
+        }
+    }
+    unsigned int nodeCount = aggrTrees.size();
+    std::vector<std::vector<unsigned int>> adjacencyList(nodeCount);
+    for (unsigned int i = 0; i < nodeCount; ++i)
+        for (unsigned int j = i + 1; j < nodeCount && treeIdxToJobIdx[i] == treeIdxToJobIdx[j]; ++j) {
+            adjacencyList[i].push_back(j);
+            adjacencyList[j].push_back(i);
+        }
+    auto treeIndex = resources.CreateAggrTreeIndex();
+    for (unsigned int i = 0; i < nodeCount; ++i)
+        treeIndex.Register(i, aggrTrees[i]);
+    for (unsigned int i = 0; i < nodeCount; ++i)
+        for (auto j : treeIndex.GetConflictingTrees(aggrTrees[i]))
+            if (j != i)
+                adjacencyList[i].push_back(j);
+    std::vector<unsigned int> nodeOffsets = {0}, edges;
+    for (auto &list : adjacencyList) {
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        edges.insert(edges.end(), list.cbegin(), list.cend());
+        nodeOffsets.push_back(edges.size());
+    }
+    unsigned int edgeCount = edges.size() / 2;
+    // The solvers change the graph, so each iteration solves a copy, as Graph::CalcMaxIndependentSet builds one
+    auto runSolver = [&](const char *solverName, auto solve) {
+        runner.Run("mis_solver",
+                   {{"degree", degree},
+                    {"mix", mix},
+                    {"solver", solverName},
+                    {"node_count", nodeCount},
+                    {"edge_count", edgeCount}},
+                   [&]() {
+                       MisSolver solver(nodeCount, edgeCount, std::vector<unsigned int>(nodeOffsets),
+                                        std::vector<unsigned int>(edges));
+                       auto inMis = solve(solver);
+                       return static_cast<std::size_t>(std::count(inMis.cbegin(), inMis.cend(), 1));
+                   });
+    };
+    runSolver("linear", [](MisSolver &solver) { return solver.LinearSolver(); });
+    runSolver("near_linear", [](MisSolver &solver) { return solver.NearLinearSolver(); });
+}
+
+// Runs the events of a job of 4 groups of 8 CommOps without SHARP and without end, one event per iteration.
+static void RunJobBenchmarks(BenchmarkRunner &runner) {
+    std::vector<CommOpGroup> commOpGroups;
+    for (unsigned int groupIdx = 0; groupIdx < 4; ++groupIdx) {
+        auto &opGroup = commOpGroups.emplace_back();
+        for (unsigned int opIdx = 0; opIdx < 8; ++opIdx)
+            opGroup.CommOps.emplace_back(opIdx * 0.001, (opIdx + 1) * 1'000'000ull, CommOp::Type::AllReduce);
+        opGroup.SyncTime = 0.01;
+    }
+    Job job(8, std::nullopt, std::move(commOpGroups), DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    job.SetBeforeTransmissionCallback([](const Job &, double) { return CommOpScheduleResult(false); });
+    double now = 0.0;
+    runner.Run("job_run_next_event", {{"dispatch", "callbacks"}}, [&]() {
+        now = job.GetNextEvent(now);
+        job.RunNextEvent(now);
+        return static_cast<std::size_t>(job.GetCurrentOpIdx());
+    });
+    struct Hooks {
+        CommOpScheduleResult BeforeTransmission(const Job &, double) { return CommOpScheduleResult(false); }
+        void AfterTransmission(const Job &, double) {}
+    } hooks;
+    runner.Run("job_run_next_event", {{"dispatch", "hooks"}}, [&]() {
+        now = job.GetNextEvent(now);
+        job.RunNextEvent(now, hooks);
+        return static_cast<std::size_t>(job.GetCurrentOpIdx());
+    });
+}
+
+void RunKernelBenchmarks(BenchmarkRunner &runner, const std::vector<unsigned int> &degrees) {
+    for (auto degree : degrees) {
+        runner.Run("fat_tree_construction", {{"degree", degree}}, [degree]() { return FatTree(degree).Edges.size(); });
+        FatTree topology(degree);
+        for (const auto &mix : JobSizeMixes) {
+            if (runner.IsAnySelected({"get_closest_common_ancestors", "get_aggregation_tree"}))
+                RunTopologyBenchmarks(runner, topology, mix);
+            if (runner.IsAnySelected({"check_tree_conflict_usage", "check_tree_conflict_pair"}))
+                RunTreeConflictBenchmarks(runner, topology, mix);
+            if (runner.IsAnySelected({"host_allocation"}))
+                RunHostAllocationBenchmarks(runner, topology, mix);
+            if (runner.IsAnySelected({"mis_solver"}))
+                RunMisSolverBenchmarks(runner, topology, mix);
+        }
+    }
+    RunJobBenchmarks(runner);
+}
@@ -0,0 +1,92 @@
+#include "benchmark.hpp"
+#include "utils/trace.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+int main(int argc, const char *argv[]) {
+    if (argc < 3)
+        return 1;
+    std::string name = argv[1];
+    // Usage: kernels <output path> [--filter <name part>] [--degrees <degree,...>] [--quick]
+    if (name == "kernels") {
+        BenchmarkRunner runner;
+        std::vector<unsigned int> degrees = {4, 8, 16, 32, 64};
+        for (int i = 3; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--filter" && i + 1 < argc)
+                runner.Filter = argv[++i];
+            else if (option == "--degrees" && i + 1 < argc) {
+                degrees.clear();
+                std::istringstream stream(argv[++i]);
+                for (std::string degree; std::getline(stream, degree, ',');)
+                    degrees.push_back(std::stoul(degree));
+                // The job sizes are drawn relative to the racks and the pods, which need an even degree of 4 or more
+                auto isInvalid = [](unsigned int degree) { return degree < 4 || degree % 2; };
+                if (std::any_of(degrees.cbegin(), degrees.cend(), isInvalid)) {
+                    std::cerr << "Degrees must be even and at least 4" << std::endl;
+                    return 1;
+                }
+            } else if (option == "--quick") {
+                runner.MinSampleTime = 0.01;
+                runner.SampleCount = 3;
+            } else {
+                std::cerr << "Unknown option " << option << std::endl;
+                return 1;
+            }
+        }
+        RunKernelBenchmarks(runner, degrees);
+        nlohmann::ordered_json report = {{"tracing", Tracer::IsEnabled},
+                                         {"min_sample_time", runner.MinSampleTime},
+                                         {"sample_count", runner.SampleCount},
+                                         {"benchmarks", runner.GetResults()}};
+        std::ofstream(argv[2]) << report.dump(4) << std::endl;
+        return 0;
+    }
+    // Usage: scenarios <output path> [--filter <name part>] [--repetitions <count>] [--baseline <baseline path>]
+    // [--throughput-tolerance <fraction>] [--metric-tolerance <fraction>], which fails if any scenario regresses
+    if (name == "scenarios") {
+        std::string filter, baselinePath;
+        unsigned int repetitionCount = 1;
+        double throughputTolerance = 0.2, metricTolerance = 1e-9;
+        for (int i = 3; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--filter" && i + 1 < argc)
+                filter = argv[++i];
+            else if (option == "--repetitions" && i + 1 < argc)
+                repetitionCount = std::max(1ul, std::stoul(argv[++i]));
+            else if (option == "--baseline" && i + 1 < argc)
+                baselinePath = argv[++i];
+            else if (option == "--throughput-tolerance" && i + 1 < argc)
+                throughputTolerance = std::stod(argv[++i]);
+            else if (option == "--metric-tolerance" && i + 1 < argc)
+                metricTolerance = std::stod(argv[++i]);
+            else {
+                std::cerr << "Unknown option " << option << std::endl;
+                return 1;
+            }
+        }
+        // Read before running, so that a missing baseline fails at once
+        nlohmann::ordered_json baseline;
+        if (!baselinePath.empty()) {
+            std::ifstream file(baselinePath);
+            if (!file) {
+                std::cerr << "Cannot open " << baselinePath << std::endl;
+                return 1;
+            }
+            baseline = nlohmann::ordered_json::parse(file);
+        }
+        nlohmann::ordered_json report = {{"tracing", Tracer::IsEnabled},
+                                         {"repetitions", repetitionCount},
+                                         {"scenarios", RunScenarios(filter, repetitionCount)}};
+        bool isRegressed = false;
+        if (!baselinePath.empty())
+            report["comparison"] =
+                CompareScenarios(report["scenarios"], baseline, throughputTolerance, metricTolerance, isRegressed);
+        std::ofstream(argv[2]) << report.dump(4) << std::endl;
+        return isRegressed ? 1 : 0;
+    }
+    return 1;
+}
@@ -0,0 +1,159 @@
+#include "benchmark.hpp"
+#include "experiments/sweep.hpp"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+#if defined(__linux__)
+#include <malloc.h>
+#endif
+
+// The full simulations, each given as the settings of a sweep run.
+static const std::vector<std::pair<std::string, nlohmann::json>> Scenarios = {
+    // The large-scale simulation on the first host count trace with the policies of Mina and of the baseline
+    {"large_scale_mina",
+     {{"host_allocation", "smart"},
+      {"tree_building", "smart"},
+      {"sharing", "smart"},
+      {"fast_forward", true},
+      {"period_skipping", true}}},
+    {"large_scale_baseline", {{"fast_forward", true}, {"period_skipping", true}}},
+    // Many jobs with the first policies, one event at a time, on the duration model of TestTreeConflicts
+    {"tree_conflicts",
+     {{"workload", {{"host_count_trace", 0}, {"job_count", 20000}}},
+      {"duration_model", {{"bandwidth", 2'000'000'000.0}, {"sharp_acc_ratio", 1.0}}}}},
+    // The policies of Mina on 8 times as many hosts, where the smart tree building policy solves large conflict graphs
+    {"stress_k32",
+     {{"topology", {{"k", 32}}},
+      {"host_allocation", "smart"},
+      {"tree_building", "smart"},
+      {"sharing", "smart"},
+      {"fast_forward", true},
+      {"period_skipping", true}}},
+};
+
+// The fields of SimulationResult that time the policies, which are reported as phases rather than compared as metrics
+static const std::vector<std::string> TimingFields = {"TimeCostHostAllocation", "TimeCostTreeBuilding"};
+
+// Resets the peak resident set size of the process where the system allows it, after giving the memory freed back.
+static void ResetPeakRss() {
+#if defined(__linux__)
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+// Returns the peak resident set size of the process in bytes since the last reset, or 0 where it is not known.
+static unsigned long long GetPeakRss() {
+#if defined(__linux__)
+    std::ifstream file("/proc/self/status");
+    for (std::string line; std::getline(file, line);)
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::stoull(line.substr(6)) * 1024;
+#endif
+    return 0;
+}
+
+nlohmann::ordered_json RunScenarios(const std::string &filter, unsigned int repetitionCount) {
+    auto reports = nlohmann::ordered_json::array();
+    for (const auto &[name, settings] : Scenarios) {
+        if (name.find(filter) == std::string::npos)
+            continue;
+        std::cout << "Running " << name << std::flush;
+        SimulationResult bestResult;
+        RunTimes bestTimes;
+        unsigned long long peakRss = 0;
+        for (unsigned int i = 0; i < repetitionCount; ++i) {
+            ResetPeakRss();
+            RunTimes times;
+            auto result = RunTimed(settings, times);
+            peakRss = std::max(peakRss, GetPeakRss());
+            if (i == 0 || times.Simulation < bestTimes.Simulation) {
+                bestResult = result;
+                bestTimes = times;
+            }
+        }
+        auto eventsPerSecond = bestResult.EventCount / bestTimes.Simulation;
+        std::cout << std::fixed << std::setprecision(3) << ": " << bestTimes.Simulation << "s, " << std::setprecision(0)
+                  << eventsPerSecond << " events/s, " << peakRss / 1'000'000 << " MB peak" << std::endl;
+        reports.push_back({{"name", name},
+                           {"settings", settings},
+                           {"wall_time", bestTimes.LoadModels + bestTimes.Setup + bestTimes.Simulation},
+                           {"phases",
+                            {{"load_models", bestTimes.LoadModels},
+                             {"setup", bestTimes.Setup},
+                             {"simulation", bestTimes.Simulation},
+                             {"host_allocation", bestResult.TimeCostHostAllocation / 1000},
+                             {"tree_building", bestResult.TimeCostTreeBuilding / 1000}}},
+                           {"events_per_second", eventsPerSecond},
+                           {"peak_rss", peakRss},
+                           {"result", ToJson(bestResult)}});
+    }
+    return reports;
+}
+
+// Returns whether the metrics are the same within the relative tolerance, where NaN, written as null, equals itself.
+static bool IsSameMetric(const nlohmann::ordered_json &value1, const nlohmann::ordered_json &value2,
+                         double tolerance) {
+    if (!value1.is_number() || !value2.is_number())
+        return value1 == value2;
+    auto number1 = value1.get<double>(), number2 = value2.get<double>();
+    return std::abs(number1 - number2) <= tolerance * std::max(std::abs(number1), std::abs(number2));
+}
+
+nlohmann::ordered_json CompareScenarios(const nlohmann::ordered_json &scenarios, const nlohmann::ordered_json &baseline,
+                                        double throughputTolerance, double metricTolerance, bool &isRegressed) {
+    isRegressed = false;
+    auto comparisons = nlohmann::ordered_json::array();
+    std::cout << std::left << std::setw(24) << "scenario" << std::right << std::setw(14) << "events/s"
+              << std::setw(14) << "baseline" << std::setw(8) << "ratio" << "  status\n";
+    const auto &baselineScenarios = baseline.at("scenarios");
+    for (const auto &scenario : scenarios) {
+        const auto &name = scenario["name"].get_ref<const std::string &>();
+        auto baselineScenario =
+            std::find_if(baselineScenarios.cbegin(), baselineScenarios.cend(),
+                         [&name](const nlohmann::ordered_json &other) { return other["name"] == name; });
+        nlohmann::ordered_json comparison = {{"name", name}};
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << scenario["events_per_second"].get<double>();
+        if (baselineScenario == baselineScenarios.cend()) {
+            comparison["status"] = "new";
+            std::cout << std::setw(22) << "" << "  new\n";
+            comparisons.push_back(std::move(comparison));
+            continue;
+        }
+        auto throughputRatio =
+            scenario["events_per_second"].get<double>() / (*baselineScenario)["events_per_second"].get<double>();
+        bool isSlower = throughputRatio < 1.0 - throughputTolerance;
+        // A change of the settings of a scenario changes its metrics as well
+        bool isSameSettings = scenario["settings"] == (*baselineScenario)["settings"];
+        auto driftedMetrics = nlohmann::ordered_json::object();
+        for (const auto &[metric, value] : scenario["result"].items()) {
+            if (std::find(TimingFields.cbegin(), TimingFields.cend(), metric) != TimingFields.cend())
+                continue;
+            auto baselineValue = (*baselineScenario)["result"].value(metric, nlohmann::ordered_json());
+            if (!IsSameMetric(value, baselineValue, metricTolerance))
+                driftedMetrics[metric] = {{"baseline", baselineValue}, {"current", value}};
+        }
+        std::string status = isSlower ? "slower" : "ok";
+        if (!isSameSettings)
+            status += ", settings changed";
+        if (!driftedMetrics.empty())
+            status += ", metrics drifted";
+        isRegressed |= isSlower || !isSameSettings || !driftedMetrics.empty();
+        comparison["status"] = status;
+        comparison["throughput_ratio"] = throughputRatio;
+        comparison["drifted_metrics"] = std::move(driftedMetrics);
+        std::cout << std::setw(14) << (*baselineScenario)["events_per_second"].get<double>() << std::setw(8)
+                  << std::setprecision(2) << throughputRatio << "  " << status << '\n';
+        for (const auto &[metric, values] : comparison["drifted_metrics"].items())
+            std::cout << "    " << metric << ": " << values["baseline"] << " -> " << values["current"] << '\n';
+        comparisons.push_back(std::move(comparison));
+    }
+    std::cout << std::flush;
+    return comparisons;
+}
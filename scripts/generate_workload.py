@@ -0,0 +1,21 @@
+import csv
+import random
+
+# Poisson arrivals with the job sizes of the first host count trace and the models of the experiments
+file_path = "data/workload.csv"
+job_count = 2000
+mean_interarrival_time = 0.15
+host_count_trace = [(1, 10910), (2, 9719), (4, 16374), (8, 23311), (16, 23936), (32, 13268), (48, 2089), (64, 329), (128, 61)]
+models = ["opt-125m-4", "opt-350m-4", "opt-1.3b-4", "bert-base-4", "bert-large-4", "vit-base-4", "vit-large-4"]
+step_counts = [10, 20, 30, 40, 50, 60, 70, 80, 90, 100]
+
+rng = random.Random(42)
+host_counts, weights = zip(*host_count_trace)
+
+with open(file_path, "w", newline="") as f:
+    writer = csv.writer(f)
+    writer.writerow(["submit_time", "host_count", "model", "step_count"])
+    submit_time = 0.0
+    for _ in range(job_count):
+        submit_time += rng.expovariate(1 / mean_interarrival_time)
+        writer.writerow([f"{submit_time:.6f}", rng.choices(host_counts, weights)[0], rng.choice(models), rng.choice(step_counts)])
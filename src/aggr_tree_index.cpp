@@ -0,0 +1,58 @@
+#include "aggr_tree_index.hpp"
+#include <algorithm>
+#include <cassert>
+
+AggrTreeIndex::AggrTreeIndex(const FatTree &topology, bool indexNodes, bool indexEdges)
+    : m_IndexNodes(indexNodes), m_IndexEdges(indexEdges), m_NodeTrees(indexNodes ? topology.Nodes.size() : 0),
+      m_EdgeTrees(indexEdges ? topology.Edges.size() : 0) {}
+
+void AggrTreeIndex::Register(unsigned int key, const AggrTree &tree) {
+    assert(!Contains(key));
+    auto &[nodeIds, edgeIds] = m_Trees[key];
+    const auto &[nodes, edges] = tree;
+    if (m_IndexNodes)
+        for (auto node : nodes) {
+            if (node->Layer == 0)
+                continue;
+            nodeIds.push_back(node->ID);
+            m_NodeTrees[node->ID].push_back(key);
+        }
+    if (m_IndexEdges)
+        for (auto edge : edges) {
+            edgeIds.push_back(edge->ID);
+            m_EdgeTrees[edge->ID].push_back(key);
+        }
+}
+
+void AggrTreeIndex::Unregister(unsigned int key) {
+    auto iter = m_Trees.find(key);
+    if (iter == m_Trees.end())
+        return;
+    auto erase = [key](std::vector<unsigned int> &trees) {
+        auto treeIter = std::find(trees.begin(), trees.end(), key);
+        assert(treeIter != trees.end());
+        *treeIter = trees.back();
+        trees.pop_back();
+    };
+    const auto &[nodeIds, edgeIds] = iter->second;
+    for (auto nodeId : nodeIds)
+        erase(m_NodeTrees[nodeId]);
+    for (auto edgeId : edgeIds)
+        erase(m_EdgeTrees[edgeId]);
+    m_Trees.erase(iter);
+}
+
+std::vector<unsigned int> AggrTreeIndex::GetConflictingTrees(const AggrTree &tree) const {
+    std::vector<unsigned int> keys;
+    const auto &[nodes, edges] = tree;
+    if (m_IndexNodes)
+        for (auto node : nodes)
+            if (node->Layer > 0)
+                keys.insert(keys.end(), m_NodeTrees[node->ID].cbegin(), m_NodeTrees[node->ID].cend());
+    if (m_IndexEdges)
+        for (auto edge : edges)
+            keys.insert(keys.end(), m_EdgeTrees[edge->ID].cbegin(), m_EdgeTrees[edge->ID].cend());
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "fat_tree.hpp"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// An inverted index from switches and links to the aggregation trees using them, so that the registered trees
+// conflicting with a tree are found by walking the nodes and edges of that tree only. Hosts are not indexed since they
+// are never shared by different jobs.
+class AggrTreeIndex {
+private:
+    using AggrTree = typename FatTree::AggrTree;
+
+    bool m_IndexNodes;
+    bool m_IndexEdges;
+    std::vector<std::vector<unsigned int>> m_NodeTrees;
+    std::vector<std::vector<unsigned int>> m_EdgeTrees;
+    // The indexed node IDs and edge IDs of each registered tree.
+    std::unordered_map<unsigned int, std::pair<std::vector<unsigned int>, std::vector<unsigned int>>> m_Trees;
+
+public:
+    // Trees conflict if they share a switch when indexNodes is set, or a link when indexEdges is set.
+    explicit AggrTreeIndex(const FatTree &topology, bool indexNodes, bool indexEdges);
+
+    bool Contains(unsigned int key) const { return m_Trees.count(key) > 0; }
+    unsigned int Size() const { return m_Trees.size(); }
+
+    void Register(unsigned int key, const AggrTree &tree);
+    // Does nothing if no tree is registered with the key.
+    void Unregister(unsigned int key);
+    // Returns the sorted keys of the registered trees conflicting with the tree, including the tree itself if it is
+    // registered.
+    std::vector<unsigned int> GetConflictingTrees(const AggrTree &tree) const;
+};
@@ -1,55 +1,204 @@
 #include "allocation_controller.hpp"
+#include "specialized_controllers.hpp"
+#include "steady_state_monitor.hpp"
+#include "utils/binary_stream.hpp"
+#include "utils/trace.hpp"
 #include "utils/union_find.hpp"
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <nlohmann/json.hpp>
+#include <stdexcept>
 
-void AllocationController::BuildSharingGroups() {
-    UnionFind u(m_RunningJobs.size());
-    for (unsigned int i = 0; i < m_RunningJobs.size(); ++i) {
-        const auto &aggrTree1 = m_RunningJobs[i]->GetNextAggrTree();
-        if (!aggrTree1)
+static constexpr std::array<char, 8> CheckpointMagic = {'M', 'I', 'N', 'A', 'C', 'K', 'P', 'T'};
+static constexpr std::uint32_t CheckpointVersion = 4;
+
+// Only the totals are saved, one by one, as the rest of the result is recomputed from them by CalcResult.
+static void WriteResultTotals(BinaryWriter &writer, const SimulationResult &result) {
+    writer.Write(result.FinishedJobCount);
+    writer.Write(result.TotalHostTime);
+    writer.Write(result.TotalJCT);
+    writer.Write(result.TotalJCTWithSharp);
+    writer.Write(result.TotalJCTWithoutSharp);
+    writer.Write(result.TotalSharpTime);
+    writer.Write(result.TotalSharpUsage);
+    writer.Write(result.TimeCostHostAllocation);
+    writer.Write(result.TimeCostTreeBuilding);
+    writer.Write(result.TreeMigrationCount);
+    writer.Write(result.SharpEnabledJobCount);
+    writer.Write(result.ConsensusFrequency);
+    writer.Write(result.EventCount);
+    writer.Write(result.AllocatedJobCount);
+    writer.Write(result.TotalQueueingDelay);
+    writer.Write(result.MaxQueueingDelay);
+}
+
+static SimulationResult ReadResultTotals(BinaryReader &reader) {
+    SimulationResult result;
+    result.FinishedJobCount = reader.Read<unsigned int>();
+    result.TotalHostTime = reader.Read<double>();
+    result.TotalJCT = reader.Read<double>();
+    result.TotalJCTWithSharp = reader.Read<double>();
+    result.TotalJCTWithoutSharp = reader.Read<double>();
+    result.TotalSharpTime = reader.Read<double>();
+    result.TotalSharpUsage = reader.Read<double>();
+    result.TimeCostHostAllocation = reader.Read<double>();
+    result.TimeCostTreeBuilding = reader.Read<double>();
+    result.TreeMigrationCount = reader.Read<unsigned int>();
+    result.SharpEnabledJobCount = reader.Read<unsigned int>();
+    result.ConsensusFrequency = reader.Read<double>();
+    result.EventCount = reader.Read<unsigned long long>();
+    result.AllocatedJobCount = reader.Read<unsigned int>();
+    result.TotalQueueingDelay = reader.Read<double>();
+    result.MaxQueueingDelay = reader.Read<double>();
+    return result;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::TransmissionHooks::BeforeTransmission(const Job &job, double,
+                                                                                              bool useSharp) {
+    if (useSharp) {
+        const auto &aggrTree = job.GetCurrentCompactAggrTree();
+        assert(aggrTree);
+        Resources.Allocate(*aggrTree);
+    }
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::TransmissionHooks::AfterTransmission(const Job &job, double,
+                                                                                             bool useSharp) {
+    if (useSharp) {
+        const auto &aggrTree = job.GetCurrentCompactAggrTree();
+        assert(aggrTree);
+        Resources.Deallocate(*aggrTree);
+    }
+}
+
+template <typename THost, typename TTree, typename TSharing>
+unsigned int BasicAllocationController<THost, TTree, TSharing>::AddSharingGroup(std::vector<Job *> &&jobs, double now) {
+    std::sort(jobs.begin(), jobs.end(), [](const Job *job1, const Job *job2) { return job1->ID < job2->ID; });
+    auto sharingGroup = std::make_unique<SharingGroup>(std::move(jobs), &m_Resources, &m_Context, now);
+    unsigned int slot;
+    if (m_FreeSharingGroupSlots.empty()) {
+        slot = m_SharingGroups.size();
+        m_SharingGroups.emplace_back();
+    } else {
+        slot = m_FreeSharingGroupSlots.back();
+        m_FreeSharingGroupSlots.pop_back();
+    }
+    for (auto job : sharingGroup->Jobs) {
+        m_JobSharingGroups[job->ID] = {slot, job->GetAggrTreeVersion()};
+        if (EventTracer)
+            job->SetTracer(EventTracer->IsJobTraced(job->ID, sharingGroup->Jobs.size()) ? EventTracer : nullptr);
+    }
+    m_EventHeap.Push(slot, sharingGroup->GetNextEventKey());
+    m_SharingGroups[slot] = std::move(sharingGroup);
+    return slot;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+std::vector<Job *> BasicAllocationController<THost, TTree, TSharing>::RemoveSharingGroup(unsigned int slot) {
+    assert(m_SharingGroups[slot]);
+    if (m_SharingGroups[slot]->IsSkipping()) {
+        m_Result.EventCount += m_SharingGroups[slot]->StopSkipping(m_LastEvent, m_SharingPolicy, m_TransmissionHooks);
+        m_SkippingSharingGroups.erase(slot);
+    }
+    std::vector<Job *> jobs;
+    for (auto job : m_SharingGroups[slot]->Jobs) {
+        m_JobSharingGroups.erase(job->ID);
+        if (job->IsFastForwarding()) {
+            StopFastForward(job);
+            m_FastForwardingJobs.erase(job);
+        }
+        if (!job->IsFinished())
+            jobs.push_back(job);
+    }
+    if (m_EventHeap.Contains(slot))
+        m_EventHeap.Erase(slot);
+    m_SharingGroups[slot].reset();
+    m_FreeSharingGroupSlots.push_back(slot);
+    return jobs;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::BuildSharingGroups(double now) {
+    if (m_UngroupedJobs.empty())
+        return;
+    // Units [0, m_UngroupedJobs.size()) are the ungrouped jobs, the rest are existing groups they conflict with.
+    std::unordered_map<unsigned int, unsigned int> ungroupedJobIndices;
+    for (unsigned int i = 0; i < m_UngroupedJobs.size(); ++i) {
+        auto job = m_UngroupedJobs[i];
+        ungroupedJobIndices[job->ID] = i;
+        m_Resources.UnregisterTree(job->ID);
+        if (job->GetNextAggrTree())
+            m_Resources.RegisterTree(job->ID, *job->GetNextAggrTree());
+    }
+    std::vector<std::pair<unsigned int, unsigned int>> conflicts;
+    std::unordered_map<unsigned int, unsigned int> slotUnits;
+    for (unsigned int i = 0; i < m_UngroupedJobs.size(); ++i) {
+        const auto &aggrTree = m_UngroupedJobs[i]->GetNextAggrTree();
+        if (!aggrTree)
             continue;
-        for (unsigned int j = i + 1; j < m_RunningJobs.size(); ++j) {
-            const auto &aggrTree2 = m_RunningJobs[j]->GetNextAggrTree();
-            if (!aggrTree2)
+        for (auto jobId : m_Resources.GetConflictingTrees(*aggrTree)) {
+            auto iter = ungroupedJobIndices.find(jobId);
+            if (iter != ungroupedJobIndices.cend()) {
+                if (iter->second > i)
+                    conflicts.emplace_back(i, iter->second);
                 continue;
-            if (m_Resources.CheckTreeConflict(*aggrTree1, *aggrTree2))
-                u.Union(i, j);
+            }
+            auto slot = m_JobSharingGroups.at(jobId).first;
+            auto unit = slotUnits.try_emplace(slot, m_UngroupedJobs.size() + slotUnits.size()).first->second;
+            conflicts.emplace_back(i, unit);
         }
     }
-    m_SharingGroups.clear();
+    std::vector<unsigned int> unitSlots(slotUnits.size());
+    for (auto [slot, unit] : slotUnits)
+        unitSlots[unit - m_UngroupedJobs.size()] = slot;
+    UnionFind u(m_UngroupedJobs.size() + unitSlots.size());
+    for (auto [unit1, unit2] : conflicts)
+        u.Union(unit1, unit2);
     for (const auto &[_, group] : u.Group()) {
         std::vector<Job *> jobs;
-        for (auto i : group)
-            jobs.push_back(m_RunningJobs[i].get());
-        auto sharingGroup = std::make_unique<SharingGroup>(std::move(jobs), &m_Resources, m_SharingPolicy);
-        sharingGroup->SetBeforeTransmissionCallback([this](const Job &job, double, bool useSharp) {
-            if (useSharp) {
-                const auto &aggrTree = job.GetCurrentAggrTree();
-                assert(aggrTree);
-                m_Resources.Allocate(*aggrTree);
-            }
-        });
-        sharingGroup->SetAfterTransmissionCallback([this](const Job &job, double, bool useSharp) {
-            if (useSharp) {
-                const auto &aggrTree = job.GetCurrentAggrTree();
-                assert(aggrTree);
-                m_Resources.Deallocate(*aggrTree);
+        for (auto unit : group)
+            if (unit < m_UngroupedJobs.size())
+                jobs.push_back(m_UngroupedJobs[unit]);
+            else {
+                auto groupJobs = RemoveSharingGroup(unitSlots[unit - m_UngroupedJobs.size()]);
+                jobs.insert(jobs.end(), groupJobs.cbegin(), groupJobs.cend());
             }
-        });
-        m_SharingGroups.push_back(std::move(sharingGroup));
+        AddSharingGroup(std::move(jobs), now);
     }
+    m_UngroupedJobs.clear();
 }
 
-void AllocationController::RunNewJobs(bool rebuildSharingGroups, SimulationResult &result) {
+template <typename THost, typename TTree, typename TSharing>
+std::unique_ptr<Job> BasicAllocationController<THost, TTree, TSharing>::TakeNextJob() {
+    if (!m_SubmittedJobs.empty()) {
+        auto job = std::move(m_SubmittedJobs.front());
+        m_SubmittedJobs.pop_front();
+        return job;
+    }
+    if (m_IsJobSourceEnded)
+        return nullptr;
+    auto job = m_GetNextJob();
+    m_IsJobSourceEnded = !job;
+    if (job)
+        job->ID = m_Context.NextJobID++;
+    return job;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::RunNewJobs(double now, SimulationResult &result) {
     std::vector<Job *> newJobs;
-    while (m_NextJob) {
+    while (m_NextJob && m_NextJob->GetSubmitTime() <= now) {
         auto start = std::chrono::high_resolution_clock::now();
-        auto hosts = m_HostAllocationPolicy(m_Resources, m_NextJob->HostCount);
+        auto hosts = m_HostAllocationPolicy(m_Resources, *m_NextJob, m_Context);
         auto finish = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
         result.TimeCostHostAllocation += duration.count() / 1000.0;
@@ -57,17 +206,37 @@ void AllocationController::RunNewJobs(bool rebuildSharingGroups, SimulationResul
             break;
         m_Resources.Allocate(*hosts);
         m_NextJob->SetHosts(std::move(*hosts));
+        auto queueingDelay = now - m_NextJob->GetSubmitTime();
+        ++result.AllocatedJobCount;
+        result.TotalQueueingDelay += queueingDelay;
+        result.MaxQueueingDelay = std::max(result.MaxQueueingDelay, queueingDelay);
         newJobs.push_back(m_NextJob.get());
+        m_JobAllocationIndices[m_NextJob->ID] = m_AllocatedJobCount;
         m_RunningJobs.push_back(std::move(m_NextJob));
         ++m_AllocatedJobCount;
-        m_NextJob = m_GetNextJob();
+        m_NextJob = TakeNextJob();
     }
     if (!newJobs.empty()) {
+        // The tree building policy sees the current state of every job
+        StopSkipping();
         auto start = std::chrono::high_resolution_clock::now();
-        m_TreeBuildingPolicy(m_Resources, m_RunningJobs, newJobs);
+        m_TreeBuildingPolicy(m_Resources, m_RunningJobs, newJobs, m_Context);
         auto finish = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
         result.TimeCostTreeBuilding += duration.count() / 1000.0;
+        if (m_FastForward || m_SkipPeriods || m_Parallel)
+            for (const auto &job : m_RunningJobs)
+                if (job->IsMigratingAggrTree())
+                    m_MigratingJobs.insert(job.get());
+        // Jobs whose aggregation tree is changed have to be regrouped, and so do the other jobs in their groups
+        for (const auto &job : m_RunningJobs) {
+            auto iter = m_JobSharingGroups.find(job->ID);
+            if (iter != m_JobSharingGroups.cend() && iter->second.second != job->GetAggrTreeVersion()) {
+                auto groupJobs = RemoveSharingGroup(iter->second.first);
+                m_UngroupedJobs.insert(m_UngroupedJobs.end(), groupJobs.cbegin(), groupJobs.cend());
+            }
+        }
+        m_UngroupedJobs.insert(m_UngroupedJobs.end(), newJobs.cbegin(), newJobs.cend());
         for (auto job : newJobs)
             if (ExclusiveAggrTree && job->GetCurrentAggrTree()) {
                 ++result.SharpEnabledJobCount;
@@ -82,27 +251,155 @@ void AllocationController::RunNewJobs(bool rebuildSharingGroups, SimulationResul
             m_Resources.CalcHostFragments(true),
         };
     }
-    if (!newJobs.empty() || rebuildSharingGroups)
-        BuildSharingGroups();
+    BuildSharingGroups(now);
+    // Skipped events may have been stopped and new jobs have come
+    if (m_Parallel)
+        for (const auto &job : m_RunningJobs)
+            UpdateFinishTimeBound(*job, now);
+}
+
+template <typename THost, typename TTree, typename TSharing>
+bool BasicAllocationController<THost, TTree, TSharing>::TryFastForward(Job *job, SharingGroup *sharingGroup,
+                                                                       double now) {
+    if (!job->StepCount || !job->IsAtStepBeginning(now) || job->IsTraced())
+        return false;
+    // The job is the only one in its group and no other group shares its quota-limited resources, so the decision
+    // stays the same for every CommOp until the group is changed.
+    auto scheduleRes = m_SharingPolicy(*sharingGroup, *job, now);
+    if (scheduleRes.InsertWaitingTime || scheduleRes.MessageSize != -1ull)
+        return false;
+    job->StartFastForward(now, scheduleRes.UseSharp);
+    sharingGroup->UpdateNextEvent(now, *job);
+    return true;
 }
 
-std::tuple<double, Job *, SharingGroup *> AllocationController::GetNextEvent(double now) {
-    double nearestEventTime;
-    Job *nearestJob = nullptr;
-    SharingGroup *nearestSharingGroup = nullptr;
-    for (auto &sharingGroup : m_SharingGroups) {
-        auto [nextEventTime, nextJob] = sharingGroup->GetNextEvent(now);
-        if (!nearestJob || nextEventTime < nearestEventTime) {
-            nearestEventTime = nextEventTime;
-            nearestJob = nextJob;
-            nearestSharingGroup = sharingGroup.get();
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::StopFastForward(Job *job) {
+    // Simultaneous events are run in the order of job ID
+    auto [now, lastJobId] = m_LastEvent;
+    job->StopFastForward(now, job->ID < lastJobId);
+    // The transmission has begun without the callback that allocates its tree
+    if (job->IsRunning() && job->IsUsingSharp()) {
+        const auto &aggrTree = job->GetCurrentCompactAggrTree();
+        assert(aggrTree);
+        m_Resources.Allocate(*aggrTree);
+    }
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::StopSkipping() {
+    for (auto job : m_FastForwardingJobs) {
+        StopFastForward(job);
+        auto slot = m_JobSharingGroups.at(job->ID).first;
+        m_SharingGroups[slot]->UpdateNextEvent(m_LastEvent.first, *job);
+        m_EventHeap.Update(slot, m_SharingGroups[slot]->GetNextEventKey());
+    }
+    m_FastForwardingJobs.clear();
+    for (auto slot : m_SkippingSharingGroups) {
+        m_Result.EventCount += m_SharingGroups[slot]->StopSkipping(m_LastEvent, m_SharingPolicy, m_TransmissionHooks);
+        m_EventHeap.Update(slot, m_SharingGroups[slot]->GetNextEventKey());
+    }
+    m_SkippingSharingGroups.clear();
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::UpdateFinishTimeBound(const Job &job, double now) {
+    m_FinishTimeBounds.PushOrUpdate(job.ID, job.CalcFinishTimeLowerBound(now));
+}
+
+template <typename THost, typename TTree, typename TSharing>
+double BasicAllocationController<THost, TTree, TSharing>::CalcParallelHorizon() const {
+    auto horizon = m_FinishTimeBounds.Empty() ? std::numeric_limits<double>::infinity() : m_FinishTimeBounds.TopKey();
+    // Leave room for the rounding errors of the bounds
+    if (std::isfinite(horizon))
+        horizon -= std::abs(horizon) * 1e-9;
+    if (m_MaxSimulationTime)
+        horizon = std::min(horizon, *m_MaxSimulationTime);
+    return horizon;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+unsigned long long BasicAllocationController<THost, TTree, TSharing>::RunSharingGroupUntil(SharingGroup &sharingGroup,
+                                                                                           double horizon) {
+    unsigned long long eventCount = 0;
+    while (true) {
+        auto nextEvent = sharingGroup.GetNextEventKey();
+        if (nextEvent.first >= horizon)
+            break;
+        if (sharingGroup.IsSkipping()) {
+            eventCount += sharingGroup.StopSkipping(nextEvent, m_SharingPolicy, m_TransmissionHooks);
+            continue;
+        }
+        auto [now, job] = sharingGroup.GetNextEvent();
+        [[maybe_unused]] auto jobFinished = sharingGroup.RunNextEvent(now, job, m_SharingPolicy, m_TransmissionHooks);
+        assert(!jobFinished);
+        ++eventCount;
+        if (m_FastForward && sharingGroup.Jobs.size() == 1)
+            TryFastForward(job, &sharingGroup, now);
+        else if (m_SkipPeriods)
+            sharingGroup.TrySkipPeriods(now, *job);
+    }
+    return eventCount;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::RunSharingGroupsUntil(double horizon,
+                                                                              SimulationResult &result) {
+    std::vector<unsigned int> slots;
+    for (unsigned int slot = 0; slot < m_SharingGroups.size(); ++slot)
+        if (m_SharingGroups[slot] && m_SharingGroups[slot]->GetNextEventKey().first < horizon)
+            slots.push_back(slot);
+    std::vector<unsigned long long> eventCounts(slots.size());
+    auto runSharingGroup = [this, horizon, &slots, &eventCounts](unsigned int i) {
+        eventCounts[i] = RunSharingGroupUntil(*m_SharingGroups[slots[i]], horizon);
+    };
+    // The tracer records on one thread at a time, so the groups of traced jobs are run on this one
+    std::vector<unsigned int> parallelIndices;
+    for (unsigned int i = 0; i < slots.size(); ++i) {
+        if (m_SharingGroups[slots[i]]->IsTraced())
+            runSharingGroup(i);
+        else
+            parallelIndices.push_back(i);
+    }
+    m_ThreadPool->ParallelFor(parallelIndices.size(), [&runSharingGroup, &parallelIndices](unsigned int i) {
+        runSharingGroup(parallelIndices[i]);
+    });
+    for (unsigned int i = 0; i < slots.size(); ++i) {
+        auto slot = slots[i];
+        const auto &sharingGroup = m_SharingGroups[slot];
+        result.EventCount += eventCounts[i];
+        for (auto job : sharingGroup->Jobs) {
+            if (job->IsFastForwarding())
+                m_FastForwardingJobs.insert(job);
+            UpdateFinishTimeBound(*job, horizon);
         }
+        if (sharingGroup->IsSkipping())
+            m_SkippingSharingGroups.insert(slot);
+        else
+            m_SkippingSharingGroups.erase(slot);
+        m_EventHeap.Update(slot, sharingGroup->GetNextEventKey());
     }
-    assert(nearestJob);
-    return {nearestEventTime, nearestJob, nearestSharingGroup};
 }
 
-void AllocationController::ShowProgress(double now, bool last) {
+template <typename THost, typename TTree, typename TSharing>
+double BasicAllocationController<THost, TTree, TSharing>::GetNextArrivalTime(double now) const {
+    // A submitted job waiting for hosts is allocated only when a job finishes
+    if (m_NextJob && m_NextJob->GetSubmitTime() > now)
+        return m_NextJob->GetSubmitTime();
+    return std::numeric_limits<double>::infinity();
+}
+
+template <typename THost, typename TTree, typename TSharing>
+std::tuple<double, Job *, SharingGroup *> BasicAllocationController<THost, TTree, TSharing>::GetNextEvent() const {
+    assert(!m_EventHeap.Empty());
+    auto sharingGroup = m_SharingGroups[m_EventHeap.TopHandle()].get();
+    assert(sharingGroup);
+    auto [nextEventTime, nextJob] = sharingGroup->GetNextEvent();
+    return {nextEventTime, nextJob, sharingGroup};
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::ShowProgress(double now, bool last) {
     auto realNow = std::chrono::high_resolution_clock::now();
     if (m_LastShowProgressTime) {
         if (!last && (realNow - *m_LastShowProgressTime) < std::chrono::milliseconds(20))
@@ -122,14 +419,18 @@ void AllocationController::ShowProgress(double now, bool last) {
     std::cout << std::flush;
 }
 
-AllocationController::AllocationController(FatTreeResource &&resources, decltype(m_GetNextJob) &&getNextJob,
-                                           HostAllocationPolicy &&hostAllocationPolicy,
-                                           TreeBuildingPolicy &&treeBuildingPolicy, SharingPolicy &&sharingPolicy)
+template <typename THost, typename TTree, typename TSharing>
+BasicAllocationController<THost, TTree, TSharing>::BasicAllocationController(
+    FatTreeResource &&resources, decltype(m_GetNextJob) &&getNextJob, HostAllocationPolicy &&hostAllocationPolicy,
+    TreeBuildingPolicy &&treeBuildingPolicy, SharingPolicy &&sharingPolicy)
     : m_GetNextJob(std::move(getNextJob)), m_HostAllocationPolicy(std::move(hostAllocationPolicy)),
       m_TreeBuildingPolicy(std::move(treeBuildingPolicy)), m_SharingPolicy(std::move(sharingPolicy)),
-      m_Resources(std::move(resources)), m_NextJob(m_GetNextJob()) {}
+      m_Resources(std::move(resources)) {
+    m_NextJob = TakeNextJob();
+}
 
-AllocationController::~AllocationController() {
+template <typename THost, typename TTree, typename TSharing>
+BasicAllocationController<THost, TTree, TSharing>::~BasicAllocationController() {
     if (!RecordTreeConflicts)
         return;
     nlohmann::json data = {
@@ -140,23 +441,98 @@ AllocationController::~AllocationController() {
     file << data.dump();
 }
 
-SimulationResult AllocationController::RunSimulation(std::optional<double> maxSimulationTime, bool showProgress) {
+template <typename THost, typename TTree, typename TSharing>
+SimulationResult BasicAllocationController<THost, TTree, TSharing>::Run(std::optional<double> maxSimulationTime,
+                                                                         bool stopAtMaxTime, bool showProgress) {
     m_MaxSimulationTime = maxSimulationTime;
-    m_LastShowProgressTime = std::nullopt;
-    SimulationResult result;
-    double now = 0.0;
-    RunNewJobs(false, result);
+    if (showProgress)
+        m_LastShowProgressTime = std::nullopt;
+    auto &result = m_Result;
+    // Traced jobs are left out of skipping one by one, in TryFastForward and SharingGroup::TrySkipPeriods
+    auto canSkipEvents = !m_Context.RecordSharingOverhead &&
+                         (!m_Resources.NodeQuota || *m_Resources.NodeQuota < 2) &&
+                         (!m_Resources.LinkQuota || *m_Resources.LinkQuota < 2);
+    m_FastForward = EnableFastForward && canSkipEvents;
+    m_SkipPeriods = EnablePeriodSkipping && canSkipEvents;
+    m_Parallel = WorkerCount > 1 && canSkipEvents;
+    if (m_Parallel && (!m_ThreadPool || m_ThreadPool->GetWorkerCount() != WorkerCount))
+        m_ThreadPool = std::make_unique<ThreadPool>(WorkerCount);
+    auto now = m_Now;
+    if (!m_IsStarted) {
+        m_IsStarted = true;
+        m_LastEvent = {now, 0};
+        RunNewJobs(now, result);
+    } else {
+        // Continue from where the last call stopped, after which nothing is skipped
+        m_MigratingJobs.clear();
+        if (m_FastForward || m_SkipPeriods || m_Parallel)
+            for (const auto &job : m_RunningJobs)
+                if (job->IsMigratingAggrTree())
+                    m_MigratingJobs.insert(job.get());
+        if (m_Parallel)
+            for (const auto &job : m_RunningJobs)
+                UpdateFinishTimeBound(*job, now);
+    }
     if (showProgress)
         ShowProgress(now, false);
-    while (!m_RunningJobs.empty() && (!m_MaxSimulationTime || now <= *m_MaxSimulationTime)) {
-        auto [nextTime, job, sharingGroup] = GetNextEvent(now);
+    while ((!m_RunningJobs.empty() || GetNextArrivalTime(now) < std::numeric_limits<double>::infinity()) &&
+           (!m_MaxSimulationTime || now <= *m_MaxSimulationTime)) {
+        // Events of jobs at the submit time of the next job run before it arrives
+        auto nextArrivalTime = GetNextArrivalTime(now);
+        auto [nextTime, job, sharingGroup] =
+            m_EventHeap.Empty() ? std::tuple<double, Job *, SharingGroup *>(nextArrivalTime, nullptr, nullptr)
+                                : GetNextEvent();
+        auto isArrival = nextArrivalTime < nextTime || !job;
+        if (isArrival)
+            nextTime = nextArrivalTime;
         assert(nextTime >= now);
+        if (m_MaxSimulationTime && nextTime > *m_MaxSimulationTime &&
+            (!m_FastForwardingJobs.empty() || !m_SkippingSharingGroups.empty())) {
+            // The simulation stops at the first event after the maximum time, which may be inside a skipped step
+            m_LastEvent = {*m_MaxSimulationTime, std::numeric_limits<unsigned int>::max()};
+            StopSkipping();
+            continue;
+        }
+        if (stopAtMaxTime && nextTime > *m_MaxSimulationTime)
+            break;
+        if (m_Parallel && m_MigratingJobs.empty()) {
+            auto horizon = std::min(CalcParallelHorizon(), nextArrivalTime);
+            if (nextTime < horizon) {
+                RunSharingGroupsUntil(horizon, result);
+                continue;
+            }
+        }
+        if (isArrival) {
+            now = nextTime;
+            m_LastEvent = {now, std::numeric_limits<unsigned int>::max()};
+            if (showProgress)
+                ShowProgress(now, false);
+            RunNewJobs(now, result);
+            continue;
+        }
+        if (sharingGroup->IsSkipping()) {
+            // The end of the skipped periods is not an event of any job
+            result.EventCount += sharingGroup->StopSkipping({nextTime, job->ID}, m_SharingPolicy, m_TransmissionHooks);
+            m_SkippingSharingGroups.erase(m_EventHeap.TopHandle());
+            m_EventHeap.Update(m_EventHeap.TopHandle(), sharingGroup->GetNextEventKey());
+            if (m_Parallel)
+                for (auto j : sharingGroup->Jobs)
+                    UpdateFinishTimeBound(*j, nextTime);
+            continue;
+        }
         now = nextTime;
+        m_LastEvent = {now, job->ID};
+        ++result.EventCount;
         if (showProgress)
             ShowProgress(now, false);
-        auto jobFinished = sharingGroup->RunNextEvent(now, job);
+        auto jobFinished = sharingGroup->RunNextEvent(now, job, m_SharingPolicy, m_TransmissionHooks);
+        if (!m_MigratingJobs.empty() && !job->IsMigratingAggrTree())
+            m_MigratingJobs.erase(job);
         if (jobFinished) {
             assert(job->StepCount);
+            m_FastForwardingJobs.erase(job);
+            if (m_Parallel)
+                m_FinishTimeBounds.Erase(job->ID);
             ++result.FinishedJobCount;
             result.TotalHostTime += (job->GetFinishTime() - job->GetStartTime()) * job->HostCount;
             result.TotalJCT += job->GetFinishTime() - job->GetStartTime();
@@ -172,18 +548,102 @@ SimulationResult AllocationController::RunSimulation(std::optional<double> maxSi
                 result.TotalSharpUsage += job->GetDurationWithSharp() * occupiedSharpResource;
             }
             m_Resources.Deallocate(job->GetHosts());
+            m_Resources.UnregisterTree(job->ID);
+            m_JobAllocationIndices.erase(job->ID);
             if (ExclusiveAggrTree && job->GetCurrentAggrTree())
                 m_Resources.Deallocate(*job->GetCurrentAggrTree());
+            // The other jobs in the group may no longer conflict with each other without this job
+            auto groupJobs = RemoveSharingGroup(m_JobSharingGroups.at(job->ID).first);
+            m_UngroupedJobs.insert(m_UngroupedJobs.end(), groupJobs.cbegin(), groupJobs.cend());
             for (auto iter = m_RunningJobs.cbegin(); iter != m_RunningJobs.cend(); ++iter)
                 if (iter->get() == job) {
                     m_RunningJobs.erase(iter);
                     break;
                 }
-            RunNewJobs(true, result);
+            RunNewJobs(now, result);
+        } else {
+            // Other groups may still conflict with the old tree of a migrating job
+            if (m_MigratingJobs.empty()) {
+                if (m_FastForward && sharingGroup->Jobs.size() == 1) {
+                    if (TryFastForward(job, sharingGroup, now))
+                        m_FastForwardingJobs.insert(job);
+                } else if (m_SkipPeriods && sharingGroup->TrySkipPeriods(now, *job))
+                    m_SkippingSharingGroups.insert(m_EventHeap.TopHandle());
+            }
+            m_EventHeap.Update(m_EventHeap.TopHandle(), sharingGroup->GetNextEventKey());
+            if (m_Parallel)
+                UpdateFinishTimeBound(*job, now);
         }
     }
+    StopSkipping();
+    m_FinishTimeBounds.Clear();
+    if (stopAtMaxTime) {
+        // Every event up to the maximum time has been run, including those at it
+        now = *m_MaxSimulationTime;
+        m_LastEvent = {now, std::numeric_limits<unsigned int>::max()};
+    }
+    m_Now = now;
     if (showProgress)
         ShowProgress(now, true);
+    return CalcResult(now);
+}
+
+template <typename THost, typename TTree, typename TSharing>
+SimulationResult BasicAllocationController<THost, TTree, TSharing>::RunUntilSteadyState(
+    std::optional<double> maxSimulationTime, bool showProgress) {
+    auto &monitor = *SteadyState;
+    assert(monitor.BatchDuration > 0.0);
+    auto hostCount = m_Resources.Topology->NodesByLayer[0].size();
+    if (!monitor.IsStarted())
+        monitor.AddSample(CalcResult(m_Now), hostCount);
+    m_LastShowProgressTime = std::nullopt;
+    while (true) {
+        auto batchEndTime = m_Now + monitor.BatchDuration;
+        if (maxSimulationTime)
+            batchEndTime = std::min(batchEndTime, *maxSimulationTime);
+        // Each batch stops at its first event after its end, as RunSimulation with the end as the maximum time
+        auto result = Run(batchEndTime, false, false);
+        monitor.AddSample(result, hostCount);
+        auto isEnded = m_Now <= batchEndTime || (maxSimulationTime && batchEndTime == *maxSimulationTime);
+        if (showProgress) {
+            m_MaxSimulationTime = maxSimulationTime;
+            ShowProgress(m_Now, isEnded || monitor.IsConverged());
+        }
+        if (isEnded || monitor.IsConverged())
+            return result;
+    }
+}
+
+template <typename THost, typename TTree, typename TSharing>
+unsigned int BasicAllocationController<THost, TTree, TSharing>::SubmitJob(std::unique_ptr<Job> job) {
+    assert(job && !job->IsFinished());
+    auto jobId = job->ID = m_Context.NextJobID++;
+    ++m_SubmittedJobCount;
+    if (m_NextJob)
+        m_SubmittedJobs.push_back(std::move(job));
+    else
+        m_NextJob = std::move(job);
+    // The next RunSimulation only allocates jobs when they arrive or when a job finishes
+    if (m_IsStarted && m_NextJob->GetSubmitTime() <= m_Now)
+        RunNewJobs(m_Now, m_Result);
+    return jobId;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+std::vector<const Job *> BasicAllocationController<THost, TTree, TSharing>::GetPendingJobs() const {
+    std::vector<const Job *> jobs;
+    if (m_NextJob)
+        jobs.push_back(m_NextJob.get());
+    for (const auto &job : m_SubmittedJobs)
+        jobs.push_back(job.get());
+    return jobs;
+}
+
+template <typename THost, typename TTree, typename TSharing>
+SimulationResult BasicAllocationController<THost, TTree, TSharing>::CalcResult(double now) const {
+    // The running jobs are counted up to now in the returned result alone, so that the simulation can go on from the
+    // totals of the finished jobs
+    auto result = m_Result;
     for (const auto &job : m_RunningJobs) {
         result.TotalHostTime += (now - job->GetStartTime()) * job->HostCount;
         result.TotalJCT += job->GetCurrentGroupStartTime() - job->GetStartTime();
@@ -199,6 +659,8 @@ SimulationResult AllocationController::RunSimulation(std::optional<double> maxSi
         }
     }
     result.SimulatedTime = now;
+    result.AverageQueueingDelay =
+        result.AllocatedJobCount ? result.TotalQueueingDelay / result.AllocatedJobCount : 0.0;
     result.ClusterUtilization = result.TotalHostTime / (now * m_Resources.Topology->NodesByLayer[0].size());
     result.JCTScore =
         (result.TotalJCT - result.TotalJCTWithoutSharp) / (result.TotalJCTWithSharp - result.TotalJCTWithoutSharp);
@@ -211,3 +673,213 @@ SimulationResult AllocationController::RunSimulation(std::optional<double> maxSi
     }
     return result;
 }
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::SaveCheckpoint(std::ostream &stream) const {
+    // Skipped events are stopped and every job is grouped whenever RunSimulation returns
+    assert(m_FastForwardingJobs.empty() && m_SkippingSharingGroups.empty() && m_UngroupedJobs.empty());
+    // The submitted jobs are not taken from the job source, so loading would take them again from there
+    if (m_SubmittedJobCount)
+        throw std::runtime_error("Cannot checkpoint a simulation with jobs submitted through SubmitJob");
+    BinaryWriter writer(stream);
+    writer.Write(CheckpointMagic);
+    writer.Write(CheckpointVersion);
+    writer.Write<std::uint64_t>(m_Resources.Topology->Nodes.size());
+    writer.Write<std::uint64_t>(m_Resources.Topology->Edges.size());
+    writer.Write(m_IsStarted);
+    writer.Write(m_Now);
+    writer.Write(m_LastEvent.first);
+    writer.Write(m_LastEvent.second);
+    WriteResultTotals(writer, m_Result);
+    writer.Write(m_AllocatedJobCount);
+    writer.Write(m_NextJob != nullptr);
+    writer.WriteVector(m_Resources.GetNodeUsage());
+    writer.WriteVector(m_Resources.GetEdgeUsage());
+    // Jobs are identified by their positions in m_RunningJobs, since IDs are not kept across processes
+    std::unordered_map<const Job *, unsigned int> jobPositions;
+    std::vector<unsigned int> allocationIndices;
+    for (unsigned int i = 0; i < m_RunningJobs.size(); ++i) {
+        jobPositions[m_RunningJobs[i].get()] = i;
+        allocationIndices.push_back(m_JobAllocationIndices.at(m_RunningJobs[i]->ID));
+    }
+    writer.WriteVector(allocationIndices);
+    for (const auto &job : m_RunningJobs)
+        job->SaveState(writer);
+    writer.Write<std::uint64_t>(m_SharingGroups.size());
+    for (const auto &sharingGroup : m_SharingGroups) {
+        writer.Write(sharingGroup != nullptr);
+        if (!sharingGroup)
+            continue;
+        std::vector<unsigned int> positions, aggrTreeVersions;
+        for (auto job : sharingGroup->Jobs) {
+            positions.push_back(jobPositions.at(job));
+            aggrTreeVersions.push_back(m_JobSharingGroups.at(job->ID).second);
+        }
+        writer.WriteVector(positions);
+        writer.WriteVector(aggrTreeVersions);
+        sharingGroup->SaveState(writer);
+    }
+    writer.WriteVector(m_FreeSharingGroupSlots);
+    writer.Write<std::uint64_t>(m_HostFragmentTrace.size());
+    for (const auto &[allocatedJobCount, hostFragments] : m_HostFragmentTrace) {
+        writer.Write(allocatedJobCount);
+        writer.Write(hostFragments.first);
+        writer.Write(hostFragments.second);
+    }
+    writer.WriteVector(std::vector<std::uint8_t>(m_TreeConflictTrace.cbegin(), m_TreeConflictTrace.cend()));
+    // The random streams are given by the seed and the round alone
+    writer.Write(m_Context.Seed);
+    writer.Write(m_Context.TreeBuildingRound);
+    if (!writer.IsGood())
+        throw std::runtime_error("Cannot write checkpoint");
+}
+
+template <typename THost, typename TTree, typename TSharing>
+void BasicAllocationController<THost, TTree, TSharing>::LoadCheckpoint(std::istream &stream) {
+    assert(!m_IsStarted && m_RunningJobs.empty());
+    BinaryReader reader(stream);
+    if (reader.Read<std::array<char, 8>>() != CheckpointMagic || reader.Read<std::uint32_t>() != CheckpointVersion)
+        throw std::runtime_error("Not a checkpoint of this version");
+    const auto &topology = *m_Resources.Topology;
+    if (reader.Read<std::uint64_t>() != topology.Nodes.size() || reader.Read<std::uint64_t>() != topology.Edges.size())
+        throw std::runtime_error("Checkpoint of a different topology");
+    m_IsStarted = reader.Read<bool>();
+    m_Now = reader.Read<double>();
+    m_LastEvent.first = reader.Read<double>();
+    m_LastEvent.second = reader.Read<unsigned int>();
+    m_Result = ReadResultTotals(reader);
+    auto allocatedJobCount = reader.Read<unsigned int>();
+    auto hasNextJob = reader.Read<bool>();
+    auto nodeUsage = reader.ReadVector<unsigned int>();
+    auto edgeUsage = reader.ReadVector<unsigned int>();
+    if (nodeUsage.size() != topology.Nodes.size() || edgeUsage.size() != topology.Edges.size())
+        throw std::runtime_error("Checkpoint of a different topology");
+    m_Resources.SetUsage(std::move(nodeUsage), std::move(edgeUsage));
+    // Take the jobs from the source again, which are given the same IDs in the same order
+    auto allocationIndices = reader.ReadVector<unsigned int>();
+    unsigned int runningJobIdx = 0;
+    for (unsigned int i = 0; i < allocatedJobCount; ++i) {
+        if (!m_NextJob)
+            throw std::runtime_error("Job source ends before the checkpoint");
+        auto job = std::move(m_NextJob);
+        m_NextJob = TakeNextJob();
+        if (runningJobIdx < allocationIndices.size() && allocationIndices[runningJobIdx] == i) {
+            m_JobAllocationIndices[job->ID] = i;
+            m_RunningJobs.push_back(std::move(job));
+            ++runningJobIdx;
+        }
+    }
+    m_AllocatedJobCount = allocatedJobCount;
+    if (runningJobIdx != allocationIndices.size() || hasNextJob != (m_NextJob != nullptr))
+        throw std::runtime_error("Checkpoint of a different job source");
+    for (const auto &job : m_RunningJobs) {
+        job->LoadState(reader, topology);
+        if (job->GetNextAggrTree())
+            m_Resources.RegisterTree(job->ID, *job->GetNextAggrTree());
+    }
+    // Groups are created again in their slots, with the same next events as they had
+    m_SharingGroups.resize(reader.Read<std::uint64_t>());
+    for (unsigned int slot = 0; slot < m_SharingGroups.size(); ++slot) {
+        if (!reader.Read<bool>())
+            continue;
+        auto positions = reader.ReadVector<unsigned int>();
+        auto aggrTreeVersions = reader.ReadVector<unsigned int>();
+        if (positions.empty() || positions.size() != aggrTreeVersions.size())
+            throw std::runtime_error("Malformed sharing group in checkpoint");
+        std::vector<Job *> jobs;
+        for (auto position : positions) {
+            if (position >= m_RunningJobs.size() || m_JobSharingGroups.count(m_RunningJobs[position]->ID))
+                throw std::runtime_error("Malformed sharing group in checkpoint");
+            jobs.push_back(m_RunningJobs[position].get());
+            m_JobSharingGroups[jobs.back()->ID] = {slot, aggrTreeVersions[jobs.size() - 1]};
+        }
+        auto sharingGroup = std::make_unique<SharingGroup>(std::move(jobs), &m_Resources, &m_Context, m_Now);
+        sharingGroup->LoadState(reader);
+        if (EventTracer)
+            for (auto job : sharingGroup->Jobs)
+                job->SetTracer(EventTracer->IsJobTraced(job->ID, sharingGroup->Jobs.size()) ? EventTracer : nullptr);
+        m_EventHeap.Push(slot, sharingGroup->GetNextEventKey());
+        m_SharingGroups[slot] = std::move(sharingGroup);
+    }
+    if (m_JobSharingGroups.size() != m_RunningJobs.size())
+        throw std::runtime_error("Ungrouped job in checkpoint");
+    m_FreeSharingGroupSlots = reader.ReadVector<unsigned int>();
+    for (auto slot : m_FreeSharingGroupSlots)
+        if (slot >= m_SharingGroups.size() || m_SharingGroups[slot])
+            throw std::runtime_error("Malformed sharing group in checkpoint");
+    auto hostFragmentTraceSize = reader.Read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < hostFragmentTraceSize; ++i) {
+        auto allocatedJobCount = reader.Read<unsigned int>();
+        auto &hostFragments = m_HostFragmentTrace[allocatedJobCount];
+        hostFragments.first = reader.Read<unsigned int>();
+        hostFragments.second = reader.Read<unsigned int>();
+    }
+    auto treeConflictTrace = reader.ReadVector<std::uint8_t>();
+    m_TreeConflictTrace.assign(treeConflictTrace.cbegin(), treeConflictTrace.cend());
+    m_Context.Seed = reader.Read<unsigned int>();
+    m_Context.TreeBuildingRound = reader.Read<unsigned int>();
+}
+
+template <typename THost, typename TTree, typename TSharing>
+std::unique_ptr<BasicAllocationController<THost, TTree, TSharing>>
+BasicAllocationController<THost, TTree, TSharing>::Fork(HostAllocationPolicy &&hostAllocationPolicy,
+                                                        TreeBuildingPolicy &&treeBuildingPolicy,
+                                                        SharingPolicy &&sharingPolicy) {
+    assert(m_FastForwardingJobs.empty() && m_SkippingSharingGroups.empty() && m_UngroupedJobs.empty());
+    if (!m_JobStreamReader) {
+        m_JobStreamReader = JobStream::Create(std::move(m_GetNextJob));
+        m_GetNextJob = [reader = m_JobStreamReader] { return reader->ReadNext(); };
+    }
+    // The fork takes no job from the source when it is created, as it starts from the next job of this simulation
+    auto fork = std::make_unique<BasicAllocationController>(
+        FatTreeResource(m_Resources), [] { return std::unique_ptr<Job>(); }, std::move(hostAllocationPolicy),
+        std::move(treeBuildingPolicy), std::move(sharingPolicy));
+    fork->m_JobStreamReader = m_JobStreamReader->Clone();
+    fork->m_GetNextJob = [reader = fork->m_JobStreamReader] { return reader->ReadNext(); };
+    if (m_NextJob)
+        fork->m_NextJob = std::make_unique<Job>(*m_NextJob);
+    for (const auto &job : m_SubmittedJobs)
+        fork->m_SubmittedJobs.push_back(std::make_unique<Job>(*job));
+    fork->m_SubmittedJobCount = m_SubmittedJobCount;
+    fork->m_IsJobSourceEnded = m_IsJobSourceEnded;
+    // Jobs keep their IDs in the fork, so everything keyed by job ID is copied as is
+    std::unordered_map<const Job *, Job *> forkJobs;
+    for (const auto &job : m_RunningJobs) {
+        const auto &forkJob = fork->m_RunningJobs.emplace_back(std::make_unique<Job>(*job));
+        forkJob->SetTracer(nullptr);
+        forkJobs[job.get()] = forkJob.get();
+    }
+    fork->m_SharingGroups.resize(m_SharingGroups.size());
+    for (unsigned int slot = 0; slot < m_SharingGroups.size(); ++slot) {
+        const auto &sharingGroup = m_SharingGroups[slot];
+        if (!sharingGroup)
+            continue;
+        std::vector<Job *> jobs;
+        for (auto job : sharingGroup->Jobs)
+            jobs.push_back(forkJobs.at(job));
+        fork->m_SharingGroups[slot] =
+            std::make_unique<SharingGroup>(*sharingGroup, std::move(jobs), &fork->m_Resources, &fork->m_Context);
+    }
+    fork->m_FreeSharingGroupSlots = m_FreeSharingGroupSlots;
+    fork->m_JobSharingGroups = m_JobSharingGroups;
+    fork->m_EventHeap = m_EventHeap;
+    fork->m_AllocatedJobCount = m_AllocatedJobCount;
+    fork->m_JobAllocationIndices = m_JobAllocationIndices;
+    fork->m_LastEvent = m_LastEvent;
+    fork->m_IsStarted = m_IsStarted;
+    fork->m_Now = m_Now;
+    fork->m_Result = m_Result;
+    fork->m_HostFragmentTrace = m_HostFragmentTrace;
+    fork->m_TreeConflictTrace = m_TreeConflictTrace;
+    fork->ExclusiveAggrTree = ExclusiveAggrTree;
+    fork->EnableFastForward = EnableFastForward;
+    fork->EnablePeriodSkipping = EnablePeriodSkipping;
+    fork->WorkerCount = WorkerCount;
+    // Including the seed and the round, so that the fork makes the same random choices as this simulation would
+    fork->m_Context = m_Context;
+    return fork;
+}
+
+template class BasicAllocationController<AnyHostAllocationPolicy, AnyTreeBuildingPolicy, AnySharingPolicy>;
+template class BasicAllocationController<SmartHostAllocationPolicy, SmartTreeBuildingPolicy, SmartSharingPolicy>;
+template class BasicAllocationController<FirstHostAllocationPolicy, FirstTreeBuildingPolicy, GreedySharingPolicy>;
@@ -2,20 +2,32 @@
 
 #include "fat_tree_resource.hpp"
 #include "job.hpp"
+#include "job_stream.hpp"
 #include "sharing_group.hpp"
+#include "simulation_context.hpp"
+#include "utils/indexed_heap.hpp"
+#include "utils/thread_pool.hpp"
+#include <cassert>
 #include <chrono>
+#include <deque>
 #include <functional>
+#include <istream>
 #include <memory>
 #include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_set>
 #include <unordered_map>
 #include <vector>
 
+class SteadyStateMonitor;
+
 struct SimulationResult {
     unsigned int FinishedJobCount = 0;
-    double SimulatedTime;
-    double ClusterUtilization;
-    double JCTScore;
-    double SharpRatio;
+    double SimulatedTime = 0.0;
+    double ClusterUtilization = 0.0;
+    double JCTScore = 0.0;
+    double SharpRatio = 0.0;
     double SharpUtilization = 0.0;
 
     double TotalHostTime = 0.0;
@@ -30,33 +42,100 @@ struct SimulationResult {
     unsigned int TreeMigrationCount = 0;
     unsigned int SharpEnabledJobCount = 0;
     double ConsensusFrequency = 0.0;
+    unsigned long long EventCount = 0;
+
+    // The time from the submission to the allocation of each job, for the jobs allocated. The average is 0 if none is.
+    unsigned int AllocatedJobCount = 0;
+    double TotalQueueingDelay = 0.0;
+    double MaxQueueingDelay = 0.0;
+    double AverageQueueingDelay = 0.0;
 };
 
-class AllocationController {
+using AnyHostAllocationPolicy = std::function<std::optional<std::vector<const FatTree::Node *>>(
+    const FatTreeResource &, const Job &, SimulationContext &)>;
+using AnyTreeBuildingPolicy = std::function<void(const FatTreeResource &, const std::vector<std::unique_ptr<Job>> &,
+                                                 const std::vector<Job *> &, SimulationContext &)>;
+using AnySharingPolicy = std::function<CommOpScheduleResult(const SharingGroup &, const Job &, double)>;
+
+// The policies are called directly through their types, so that a controller specialized on concrete policies has no
+// indirect call on the path of an event. Only AllocationController at the end of this file and the controllers in
+// specialized_controllers.hpp are instantiated, in allocation_controller.cpp.
+template <typename THostAllocationPolicy, typename TTreeBuildingPolicy, typename TSharingPolicy>
+class BasicAllocationController {
 public:
-    using HostAllocationPolicy =
-        std::function<std::optional<std::vector<const FatTree::Node *>>(const FatTreeResource &, unsigned int)>;
-    using TreeBuildingPolicy = std::function<void(const FatTreeResource &, const std::vector<std::unique_ptr<Job>> &,
-                                                  const std::vector<Job *> &)>;
-    using SharingPolicy = std::function<CommOpScheduleResult(const SharingGroup &, const Job &, double)>;
+    using HostAllocationPolicy = THostAllocationPolicy;
+    using TreeBuildingPolicy = TTreeBuildingPolicy;
+    using SharingPolicy = TSharingPolicy;
 
 private:
-    // Returns the next job if exists, nullptr if not.
+    // Allocates the aggregation tree of each transmission that uses SHARP while it runs.
+    struct TransmissionHooks {
+        FatTreeResource &Resources;
+
+        void BeforeTransmission(const Job &job, double now, bool useSharp);
+        void AfterTransmission(const Job &job, double now, bool useSharp);
+    };
+
+    // Returns the next job if exists, nullptr if not. Jobs are allocated in this order, each once it is submitted and
+    // there are enough hosts, so jobs that are submitted later wait behind it.
     std::function<std::unique_ptr<Job>()> m_GetNextJob;
-    // Given the resources and the number of required hosts, returns a vector of hosts if there are enough available
-    // hosts, std::nullopt if not.
+    // The reader that m_GetNextJob reads from once the simulation is forked, so that every fork gets the same jobs.
+    std::shared_ptr<JobStream::Reader> m_JobStreamReader;
+    // Given the resources, the job to allocate and the context, returns a vector of hosts if there are enough
+    // available hosts, std::nullopt if not.
     HostAllocationPolicy m_HostAllocationPolicy;
-    // Given the resources, all the running jobs, and the new jobs, build the aggregation tree of each job. This
-    // function should set the aggregation trees by calling Job::SetNextAggrTree.
+    // Given the resources, all the running jobs, the new jobs and the context, build the aggregation tree of each job.
+    // This function should set the aggregation trees by calling Job::SetNextAggrTree.
     TreeBuildingPolicy m_TreeBuildingPolicy;
     // Given the sharing group, the job, and the current time, returns CommOpScheduleResult.
     SharingPolicy m_SharingPolicy;
+    // The state of this simulation that its jobs, sharing groups and policies share, which no other simulation touches.
+    SimulationContext m_Context;
 
     FatTreeResource m_Resources;
+    TransmissionHooks m_TransmissionHooks{m_Resources};
     std::vector<std::unique_ptr<Job>> m_RunningJobs;
+    // Sharing groups are kept in slots that are reused after the group is removed, empty slots are nullptr.
     std::vector<std::unique_ptr<SharingGroup>> m_SharingGroups;
+    std::vector<unsigned int> m_FreeSharingGroupSlots;
+    // The slot of the sharing group of each job keyed by job ID, and the version of the aggregation tree it was grouped
+    // with.
+    std::unordered_map<unsigned int, std::pair<unsigned int, unsigned int>> m_JobSharingGroups;
+    // Running jobs that are not in any sharing group, e.g. new jobs and jobs whose group was split.
+    std::vector<Job *> m_UngroupedJobs;
+    // The next event of each sharing group, indexed by the slot of the group.
+    IndexedHeap<SharingGroup::EventKey> m_EventHeap;
     std::unique_ptr<Job> m_NextJob;
+    // Jobs given to SubmitJob that are taken before the rest of the job source, and whether the source has ended.
+    std::deque<std::unique_ptr<Job>> m_SubmittedJobs;
+    unsigned int m_SubmittedJobCount = 0;
+    bool m_IsJobSourceEnded = false;
     unsigned int m_AllocatedJobCount = 0;
+    // The position of each running job in the order of allocation keyed by job ID, which identifies the job in
+    // checkpoints.
+    std::unordered_map<unsigned int, unsigned int> m_JobAllocationIndices;
+    // Whether fast-forwarding is enabled and valid for the current simulation, and the jobs being fast-forwarded.
+    bool m_FastForward = false;
+    std::unordered_set<Job *> m_FastForwardingJobs;
+    // Whether period skipping is enabled and valid for the current simulation, and the slots of the skipping groups.
+    bool m_SkipPeriods = false;
+    std::unordered_set<unsigned int> m_SkippingSharingGroups;
+    // Jobs that still use their old aggregation tree, which may conflict with the trees of other sharing groups. No job
+    // is fast-forwarded until they have migrated.
+    std::unordered_set<Job *> m_MigratingJobs;
+    // Whether the parallel engine is enabled and valid for the current simulation, and its workers, which are kept
+    // across calls so that the batches of the steady-state monitor and the steps of AdvanceTo do not start new ones.
+    bool m_Parallel = false;
+    std::unique_ptr<ThreadPool> m_ThreadPool;
+    // Lower bounds of the finish times of the running jobs keyed by job ID. Sharing groups do not affect each other
+    // before the earliest one or the next arrival, since jobs only arrive or have their trees rebuilt then.
+    IndexedHeap<double> m_FinishTimeBounds;
+    // The last event run, skipped events are stopped as if all the events up to it had been run.
+    SharingGroup::EventKey m_LastEvent;
+    // Where the last call to RunSimulation stopped, and the results of the finished jobs so far.
+    bool m_IsStarted = false;
+    double m_Now = 0.0;
+    SimulationResult m_Result;
 
     std::optional<double> m_MaxSimulationTime; // In second
     std::optional<std::chrono::high_resolution_clock::time_point> m_LastShowProgressTime;
@@ -64,20 +143,142 @@ private:
     std::unordered_map<unsigned int, std::pair<unsigned int, unsigned int>> m_HostFragmentTrace;
     std::vector<bool> m_TreeConflictTrace;
 
-    void BuildSharingGroups();
-    void RunNewJobs(bool rebuildSharingGroups, SimulationResult &result);
+    unsigned int AddSharingGroup(std::vector<Job *> &&jobs, double now);
+    // Removes the sharing group and returns its unfinished jobs, which are left ungrouped.
+    std::vector<Job *> RemoveSharingGroup(unsigned int slot);
+    // Groups the ungrouped jobs, merging them with the existing sharing groups whose trees conflict with theirs.
+    void BuildSharingGroups(double now);
+    // Returns the next submitted job if any, or the next job of the job source.
+    std::unique_ptr<Job> TakeNextJob();
+    void RunNewJobs(double now, SimulationResult &result);
+    // Fast-forwards the job if it is alone in its sharing group and has just begun a step. Returns whether the job is
+    // fast-forwarded.
+    bool TryFastForward(Job *job, SharingGroup *sharingGroup, double now);
+    // Stops fast-forwarding the job without updating its sharing group.
+    void StopFastForward(Job *job);
+    // Stops fast-forwarding all jobs and skipping periods of all sharing groups.
+    void StopSkipping();
+    void UpdateFinishTimeBound(const Job &job, double now);
+    // Returns the submit time of the next job if it is not submitted yet, infinity if there is no such job.
+    double GetNextArrivalTime(double now) const;
+    // Returns the time before which the sharing groups can run in parallel.
+    double CalcParallelHorizon() const;
+    // Runs the events of the sharing group before the horizon. Called on worker threads.
+    unsigned long long RunSharingGroupUntil(SharingGroup &sharingGroup, double horizon);
+    // Runs the events of all sharing groups before the horizon in parallel.
+    void RunSharingGroupsUntil(double horizon, SimulationResult &result);
     // Returns the time of the next event, the job that will run next, and the sharing group of that job.
-    std::tuple<double, Job *, SharingGroup *> GetNextEvent(double now);
+    std::tuple<double, Job *, SharingGroup *> GetNextEvent() const;
+    // Returns the result of the simulation up to now.
+    SimulationResult CalcResult(double now) const;
+    // Runs the simulation up to the maximum time. If stopAtMaxTime, the events after it are left for the next call and
+    // the clock is moved to it, otherwise the first event after it is run as well.
+    SimulationResult Run(std::optional<double> maxSimulationTime, bool stopAtMaxTime, bool showProgress);
+    // Runs the simulation in batches of the steady-state monitor until its estimates converge, the simulation ends or
+    // the first event after the maximum time.
+    SimulationResult RunUntilSteadyState(std::optional<double> maxSimulationTime, bool showProgress);
     void ShowProgress(double now, bool last);
 
 public:
     bool RecordTreeConflicts = false;
     bool ExclusiveAggrTree = false;
+    // Whether to skip the events of jobs that are alone in their sharing group, whose SHARP decision cannot change
+    // until the next job arrival or completion. Only takes effect when the quotas are at most 1 so that groups do not
+    // affect each other, and when sharing overhead recording is disabled. Jobs recorded by the tracer are never
+    // fast-forwarded. Times are extrapolated over the skipped steps, so the results differ from those without it by
+    // rounding errors, about 1e-15 relative on the large-scale simulation, and a tie between events that rounding
+    // breaks may order them differently.
+    bool EnableFastForward = false;
+    // Whether to skip whole periods of sharing groups whose schedule repeats, until the next job arrival or completion
+    // or until any job in the group is about to finish. This assumes that the sharing policy makes the same decisions
+    // whenever the relative state of the group is the same, and has the same restrictions as fast-forwarding. States
+    // match within SharingGroup::PeriodTolerance and the skipped periods are extrapolated, so the results differ from
+    // those without it by that tolerance and by rounding errors.
+    bool EnablePeriodSkipping = false;
+    // The number of threads that run the events of different sharing groups in parallel between job completions, with
+    // the same results as 1. Takes effect under the same restrictions as fast-forwarding.
+    unsigned int WorkerCount = 1;
+    // Records the events of the jobs chosen by its filter if set. Those jobs are neither fast-forwarded nor in groups
+    // that skip periods, and their groups are run on the calling thread between job completions. The tracer belongs
+    // to this simulation alone, so simulations running at the same time write to different files.
+    Tracer *EventTracer = nullptr;
+    // Stops RunSimulation once the steady-state estimates of the monitor have converged if set, which runs the
+    // simulation in batches of simulated time and adds the result at the end of each to the monitor. Fast-forwarded
+    // jobs and skipped periods are stopped at the end of each batch to take its result, and start again only at the
+    // next step or period, so with them the results differ from those of an unmonitored run within their tolerances
+    // and fewer events are skipped.
+    SteadyStateMonitor *SteadyState = nullptr;
+
+    explicit BasicAllocationController(FatTreeResource &&resources, decltype(m_GetNextJob) &&getNextJob,
+                                       HostAllocationPolicy &&hostAllocationPolicy,
+                                       TreeBuildingPolicy &&treeBuildingPolicy, SharingPolicy &&sharingPolicy);
+    ~BasicAllocationController();
 
-    explicit AllocationController(FatTreeResource &&resources, decltype(m_GetNextJob) &&getNextJob,
-                                  HostAllocationPolicy &&hostAllocationPolicy, TreeBuildingPolicy &&treeBuildingPolicy,
-                                  SharingPolicy &&sharingPolicy);
-    ~AllocationController();
+    // Runs the simulation up to the first event after the maximum time, continuing from where the last call or the
+    // loaded checkpoint stopped. The result covers the simulation from the beginning.
+    SimulationResult RunSimulation(std::optional<double> maxSimulationTime, bool showProgress) {
+        return SteadyState ? RunUntilSteadyState(maxSimulationTime, showProgress)
+                           : Run(maxSimulationTime, false, showProgress);
+    }
+    // Runs every event up to the time and stops there, so that jobs can be submitted and the state queried at exactly
+    // that time. The result covers the simulation from the beginning.
+    SimulationResult AdvanceTo(double time) {
+        assert(time >= m_Now);
+        return Run(time, true, false);
+    }
+    // Submits a job, which is taken after the jobs taken from the job source so far and before the rest of it. A job
+    // submitted at or before the current time is allocated at once if there are enough hosts, and waits like any other
+    // job if not. Checkpoints cannot be saved after a job is submitted, as the job source alone is taken again on load.
+    // Returns the ID given to the job.
+    unsigned int SubmitJob(std::unique_ptr<Job> job);
 
-    SimulationResult RunSimulation(std::optional<double> maxSimulationTime, bool showProgress);
+    double GetNow() const { return m_Now; }
+    // The context can be changed before the simulation runs, e.g. to seed the random streams of the policies or to
+    // record the sharing overhead, whose counters are read from it afterwards.
+    SimulationContext &GetContext() { return m_Context; }
+    const SimulationContext &GetContext() const { return m_Context; }
+    // Returns the result of the simulation up to where it stopped.
+    SimulationResult GetResult() const { return CalcResult(m_Now); }
+    const FatTreeResource &GetResources() const { return m_Resources; }
+    const std::vector<std::unique_ptr<Job>> &GetRunningJobs() const { return m_RunningJobs; }
+    // Returns the sharing group of a running job.
+    const SharingGroup &GetSharingGroup(const Job &job) const {
+        return *m_SharingGroups[m_JobSharingGroups.at(job.ID).first];
+    }
+    // Returns the jobs taken or submitted that are not allocated yet, in the order they will be allocated.
+    std::vector<const Job *> GetPendingJobs() const;
+
+    // The policies take effect from their next decision, and the aggregation trees already built are kept.
+    void SetHostAllocationPolicy(HostAllocationPolicy &&policy) { m_HostAllocationPolicy = std::move(policy); }
+    void SetTreeBuildingPolicy(TreeBuildingPolicy &&policy) { m_TreeBuildingPolicy = std::move(policy); }
+    void SetSharingPolicy(SharingPolicy &&policy) { m_SharingPolicy = std::move(policy); }
+
+    // Writes the complete state of the simulation where RunSimulation stopped: the usage of the resources, the state of
+    // every running job, the sharing groups, the number of jobs taken from the job source and the seed and the round of
+    // the random streams of the policies. Throws std::runtime_error if any job was submitted through SubmitJob.
+    void SaveCheckpoint(std::ostream &stream) const;
+    // Continues from a checkpoint on a controller that has not run yet, which must have the same topology, quotas,
+    // options and policies as the saved one, and a job source that returns the same jobs from the beginning. The jobs
+    // taken before the checkpoint are taken again and the finished ones dropped, so that the next RunSimulation goes on
+    // bit-identically. Throws std::runtime_error on a checkpoint that is malformed or does not fit the controller.
+    void LoadCheckpoint(std::istream &stream);
+
+    // Returns a copy of the simulation where RunSimulation stopped, which goes on with the given policies and the same
+    // options except the tracer and the recording of tree conflicts, and with a copy of the context. The models of the
+    // jobs are shared, and the jobs to come are read by both simulations from the same JobStream. The copy and this
+    // simulation can then run on different threads. The type-erased AllocationController takes policies of any types.
+    std::unique_ptr<BasicAllocationController> Fork(HostAllocationPolicy &&hostAllocationPolicy,
+                                                    TreeBuildingPolicy &&treeBuildingPolicy,
+                                                    SharingPolicy &&sharingPolicy);
+    // The same as above with the policies of this simulation.
+    std::unique_ptr<BasicAllocationController> Fork() {
+        return Fork(HostAllocationPolicy(m_HostAllocationPolicy), TreeBuildingPolicy(m_TreeBuildingPolicy),
+                    SharingPolicy(m_SharingPolicy));
+    }
 };
+
+// Takes any policies at the cost of an indirect call per policy call.
+using AllocationController =
+    BasicAllocationController<AnyHostAllocationPolicy, AnyTreeBuildingPolicy, AnySharingPolicy>;
+
+extern template class BasicAllocationController<AnyHostAllocationPolicy, AnyTreeBuildingPolicy, AnySharingPolicy>;
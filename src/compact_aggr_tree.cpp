@@ -0,0 +1,24 @@
+#include "compact_aggr_tree.hpp"
+#include "utils/id_span_kernels.hpp"
+#include <algorithm>
+
+CompactAggrTree::CompactAggrTree(const FatTree::AggrTree &tree) {
+    const auto &[nodes, edges] = tree;
+    m_IDs.reserve(nodes.size() + edges.size());
+    for (auto node : nodes)
+        if (node->Layer > 0)
+            m_IDs.push_back(node->ID);
+    m_NodeCount = m_IDs.size();
+    for (auto edge : edges)
+        m_IDs.push_back(edge->ID);
+    std::sort(m_IDs.begin(), m_IDs.begin() + m_NodeCount);
+    std::sort(m_IDs.begin() + m_NodeCount, m_IDs.end());
+}
+
+bool CompactAggrTree::SharesNode(const CompactAggrTree &other) const {
+    return IdSpanKernels::Intersect(GetNodeIDs(), GetNodeCount(), other.GetNodeIDs(), other.GetNodeCount());
+}
+
+bool CompactAggrTree::SharesEdge(const CompactAggrTree &other) const {
+    return IdSpanKernels::Intersect(GetEdgeIDs(), GetEdgeCount(), other.GetEdgeIDs(), other.GetEdgeCount());
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "fat_tree.hpp"
+#include <vector>
+
+// A compact representation of an aggregation tree: the sorted IDs of its switches and links in one contiguous span.
+// Hosts are left out since they are never shared by different jobs.
+class CompactAggrTree {
+private:
+    std::vector<unsigned int> m_IDs; // Node IDs followed by edge IDs, both sorted
+    unsigned int m_NodeCount;
+
+public:
+    explicit CompactAggrTree(const FatTree::AggrTree &tree);
+
+    const unsigned int *GetNodeIDs() const { return m_IDs.data(); }
+    unsigned int GetNodeCount() const { return m_NodeCount; }
+    const unsigned int *GetEdgeIDs() const { return m_IDs.data() + m_NodeCount; }
+    unsigned int GetEdgeCount() const { return m_IDs.size() - m_NodeCount; }
+
+    bool SharesNode(const CompactAggrTree &other) const;
+    bool SharesEdge(const CompactAggrTree &other) const;
+
+    bool operator==(const CompactAggrTree &other) const {
+        return m_NodeCount == other.m_NodeCount && m_IDs == other.m_IDs;
+    }
+    bool operator!=(const CompactAggrTree &other) const { return !(*this == other); }
+};
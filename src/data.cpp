@@ -1,6 +1,12 @@
 #include "data.hpp"
+#include "utils/mapped_file.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <tuple>
 
 double DurationCaculator::operator()(CommOp::Type opType, unsigned long long messageSize, bool useSharp,
                                      unsigned int hostCount) const {
@@ -10,20 +16,225 @@ double DurationCaculator::operator()(CommOp::Type opType, unsigned long long mes
     return Latency + messageSize / bandwidth;
 }
 
-std::vector<CommOpGroup> ModelInfoProvider::GetModelInfo(const char *modelInfoPath, double gpuSpeedupRatio) {
-    std::scoped_lock lock(m_CacheMtx);
-    if (m_ModelInfoCache.count(modelInfoPath) == 0) {
-        std::ifstream file(modelInfoPath);
-        m_ModelInfoCache[modelInfoPath] = nlohmann::json::parse(file);
-    }
-    const auto &modelInfo = m_ModelInfoCache[modelInfoPath];
-    std::vector<CommOpGroup> result(1);
-    auto &opGroup = result.front();
-    opGroup.SyncTime = modelInfo["duration"].get<double>() / gpuSpeedupRatio;
+// A binary profile file is laid out in the native byte order as a ProfileHeader, a ProfileModelEntry per model, the
+// model names, and the ProfileOpRecords of every model, each at the offsets in the entries.
+struct ProfileHeader {
+    char Magic[8];
+    std::uint32_t Version;
+    std::uint32_t ModelCount;
+};
+struct ProfileModelEntry {
+    std::uint64_t NameOffset;
+    std::uint64_t RecordOffset;
+    std::uint32_t NameLength;
+    std::uint32_t RecordCount;
+    double Duration; // In second
+};
+struct ProfileOpRecord {
+    double StartTime; // In second
+    std::uint64_t MessageSize;
+    std::uint32_t OpType;
+    std::uint32_t Reserved;
+};
+static_assert(sizeof(ProfileHeader) == 16 && sizeof(ProfileModelEntry) == 32 && sizeof(ProfileOpRecord) == 24);
+static constexpr char ProfileMagic[8] = {'M', 'I', 'N', 'A', 'P', 'R', 'O', 'F'};
+static constexpr std::uint32_t ProfileVersion = 1;
+
+// Reads a model file in the JSON format, with the step duration and the start time and size of each AllReduce.
+static void ReadModelInfo(const char *modelInfoPath, double &duration, std::vector<CommOp> &commOps) {
+    std::ifstream file(modelInfoPath);
+    auto modelInfo = nlohmann::json::parse(file);
+    duration = modelInfo["duration"].get<double>();
     for (const auto &op : modelInfo["allreduces"]) {
-        double start = op["start"].get<double>() / gpuSpeedupRatio;
+        double start = op["start"].get<double>();
         unsigned long long size = op["size"];
-        opGroup.CommOps.emplace_back(start, size, CommOp::Type::AllReduce);
+        commOps.emplace_back(start, size, CommOp::Type::AllReduce);
+    }
+}
+
+ModelRegistry::State::~State() {
+    for (const auto &model : Models)
+        for (unsigned int hostCount = 0; hostCount <= MaxHostCount; ++hostCount)
+            delete model.JobModels[hostCount].load();
+}
+
+ModelRegistry::ModelRegistry(unsigned int maxHostCount, const JobModel::DurationModel &calcTransmissionDuration)
+    : m_State(std::make_shared<State>()) {
+    m_State->MaxHostCount = maxHostCount;
+    m_State->CalcTransmissionDuration = calcTransmissionDuration;
+}
+
+ModelRegistry::ModelRegistry(const std::vector<const char *> &modelInfoPaths,
+                             const std::vector<double> &gpuSpeedupRatios, unsigned int maxHostCount,
+                             const JobModel::DurationModel &calcTransmissionDuration)
+    : ModelRegistry(maxHostCount, calcTransmissionDuration) {
+    for (auto modelInfoPath : modelInfoPaths) {
+        double duration;
+        std::vector<CommOp> commOps;
+        ReadModelInfo(modelInfoPath, duration, commOps);
+        AddModel(GetModelName(modelInfoPath), duration, commOps, gpuSpeedupRatios);
+    }
+    SortModels();
+}
+
+ModelRegistry::ModelRegistry(const char *profilePath, const std::vector<double> &gpuSpeedupRatios,
+                             unsigned int maxHostCount, const JobModel::DurationModel &calcTransmissionDuration)
+    : ModelRegistry(maxHostCount, calcTransmissionDuration) {
+    MappedFile file(profilePath);
+    if (!file.IsOpen())
+        throw std::runtime_error(std::string("Cannot read profile file ") + profilePath);
+    auto data = file.GetData();
+    auto isInFile = [&file](std::uint64_t offset, std::uint64_t size) {
+        return offset <= file.GetSize() && size <= file.GetSize() - offset;
+    };
+    ProfileHeader header;
+    if (!isInFile(0, sizeof(header)))
+        throw std::runtime_error(std::string("Malformed profile file ") + profilePath);
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.Magic, ProfileMagic, sizeof(header.Magic)) != 0 || header.Version != ProfileVersion ||
+        !isInFile(sizeof(header), std::uint64_t(header.ModelCount) * sizeof(ProfileModelEntry)))
+        throw std::runtime_error(std::string("Malformed profile file ") + profilePath);
+    std::vector<CommOp> commOps;
+    for (std::uint32_t i = 0; i < header.ModelCount; ++i) {
+        ProfileModelEntry entry;
+        std::memcpy(&entry, data + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        if (!isInFile(entry.NameOffset, entry.NameLength) ||
+            !isInFile(entry.RecordOffset, std::uint64_t(entry.RecordCount) * sizeof(ProfileOpRecord)))
+            throw std::runtime_error(std::string("Malformed profile file ") + profilePath);
+        commOps.clear();
+        for (std::uint32_t j = 0; j < entry.RecordCount; ++j) {
+            ProfileOpRecord record;
+            std::memcpy(&record, data + entry.RecordOffset + j * sizeof(record), sizeof(record));
+            commOps.emplace_back(record.StartTime, record.MessageSize, static_cast<CommOp::Type>(record.OpType));
+        }
+        std::string_view name(reinterpret_cast<const char *>(data + entry.NameOffset), entry.NameLength);
+        AddModel(name, entry.Duration, commOps, gpuSpeedupRatios);
+    }
+    SortModels();
+}
+
+void ModelRegistry::AddModel(std::string_view name, double duration, const std::vector<CommOp> &commOps,
+                             const std::vector<double> &gpuSpeedupRatios) {
+    for (auto gpuSpeedupRatio : gpuSpeedupRatios) {
+        std::vector<CommOpGroup> commOpGroups(1);
+        auto &opGroup = commOpGroups.front();
+        opGroup.SyncTime = duration / gpuSpeedupRatio;
+        for (const auto &op : commOps)
+            opGroup.CommOps.emplace_back(op.StartTimeInGroup / gpuSpeedupRatio, op.MessageSize, op.OpType);
+        auto &model = m_State->Models.emplace_back();
+        model.Name = name;
+        model.GpuSpeedupRatio = gpuSpeedupRatio;
+        model.CommOpGroups = std::make_shared<const std::vector<CommOpGroup>>(std::move(commOpGroups));
+        model.JobModels = std::make_unique<std::atomic<const JobModel *>[]>(m_State->MaxHostCount + 1);
+    }
+}
+
+void ModelRegistry::SortModels() {
+    std::sort(m_State->Models.begin(), m_State->Models.end(), [](const Model &model1, const Model &model2) {
+        return std::tie(model1.Name, model1.GpuSpeedupRatio) < std::tie(model2.Name, model2.GpuSpeedupRatio);
+    });
+}
+
+const ModelRegistry::Model *ModelRegistry::FindModel(std::string_view name, double gpuSpeedupRatio) const {
+    name = GetModelName(name);
+    const auto &models = m_State->Models;
+    auto iter = std::lower_bound(models.cbegin(), models.cend(), std::pair(name, gpuSpeedupRatio),
+                                 [](const Model &model, const std::pair<std::string_view, double> &key) {
+                                     return std::pair<std::string_view, double>(model.Name, model.GpuSpeedupRatio) <
+                                            key;
+                                 });
+    if (iter == models.cend() || iter->Name != name || iter->GpuSpeedupRatio != gpuSpeedupRatio)
+        return nullptr;
+    return &*iter;
+}
+
+const ModelRegistry::Model &ModelRegistry::GetModel(std::string_view name, double gpuSpeedupRatio) const {
+    auto model = FindModel(name, gpuSpeedupRatio);
+    if (!model)
+        throw std::runtime_error("Unknown model " + std::string(name) + " at GPU speedup ratio " +
+                                 std::to_string(gpuSpeedupRatio));
+    return *model;
+}
+
+bool ModelRegistry::Contains(std::string_view name, double gpuSpeedupRatio) const {
+    return FindModel(name, gpuSpeedupRatio) != nullptr;
+}
+
+std::shared_ptr<const std::vector<CommOpGroup>> ModelRegistry::GetCommOpGroups(std::string_view name,
+                                                                               double gpuSpeedupRatio) const {
+    return GetModel(name, gpuSpeedupRatio).CommOpGroups;
+}
+
+std::shared_ptr<const JobModel> ModelRegistry::GetJobModel(std::string_view name, double gpuSpeedupRatio,
+                                                           unsigned int hostCount) const {
+    if (hostCount > m_State->MaxHostCount)
+        throw std::runtime_error("Jobs of " + std::to_string(hostCount) + " hosts are more than the maximum of " +
+                                 std::to_string(m_State->MaxHostCount));
+    const auto &model = GetModel(name, gpuSpeedupRatio);
+    auto &slot = model.JobModels[hostCount];
+    auto jobModel = slot.load(std::memory_order_acquire);
+    if (!jobModel) {
+        // Concurrent lookups may build the same timing, only the first one is kept
+        auto newJobModel =
+            std::make_unique<const JobModel>(model.CommOpGroups, hostCount, m_State->CalcTransmissionDuration);
+        if (slot.compare_exchange_strong(jobModel, newJobModel.get(), std::memory_order_acq_rel))
+            jobModel = newJobModel.release();
+    }
+    // Owned by the state, which the handle keeps alive
+    return std::shared_ptr<const JobModel>(m_State, jobModel);
+}
+
+std::string_view ModelRegistry::GetModelName(std::string_view modelInfoPath) {
+    auto begin = modelInfoPath.find_last_of('/');
+    modelInfoPath.remove_prefix(begin == std::string_view::npos ? 0 : begin + 1);
+    auto end = modelInfoPath.rfind(".json");
+    if (end != std::string_view::npos)
+        modelInfoPath.remove_suffix(modelInfoPath.size() - end);
+    return modelInfoPath;
+}
+
+bool ModelRegistry::ConvertProfiles(const std::vector<const char *> &modelInfoPaths, const char *profilePath) {
+    std::vector<std::string_view> names;
+    std::vector<double> durations;
+    std::vector<std::vector<CommOp>> commOpLists(modelInfoPaths.size());
+    for (unsigned int i = 0; i < modelInfoPaths.size(); ++i) {
+        names.push_back(GetModelName(modelInfoPaths[i]));
+        ReadModelInfo(modelInfoPaths[i], durations.emplace_back(), commOpLists[i]);
+    }
+    // The header, the index, the names, and then the records, which are kept aligned
+    ProfileHeader header{};
+    std::memcpy(header.Magic, ProfileMagic, sizeof(header.Magic));
+    header.Version = ProfileVersion;
+    header.ModelCount = modelInfoPaths.size();
+    std::vector<ProfileModelEntry> entries(modelInfoPaths.size());
+    std::uint64_t offset = sizeof(header) + entries.size() * sizeof(ProfileModelEntry);
+    for (unsigned int i = 0; i < entries.size(); ++i) {
+        entries[i].NameOffset = offset;
+        entries[i].NameLength = names[i].size();
+        offset += names[i].size();
+    }
+    offset = (offset + alignof(ProfileOpRecord) - 1) / alignof(ProfileOpRecord) * alignof(ProfileOpRecord);
+    auto recordsOffset = offset;
+    for (unsigned int i = 0; i < entries.size(); ++i) {
+        entries[i].Duration = durations[i];
+        entries[i].RecordOffset = offset;
+        entries[i].RecordCount = commOpLists[i].size();
+        offset += commOpLists[i].size() * sizeof(ProfileOpRecord);
+    }
+    std::ofstream file(profilePath, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(ProfileModelEntry));
+    std::uint64_t namesEnd = sizeof(header) + entries.size() * sizeof(ProfileModelEntry);
+    for (auto name : names) {
+        file.write(name.data(), name.size());
+        namesEnd += name.size();
     }
-    return result;
+    std::vector<char> padding(recordsOffset - namesEnd, 0);
+    file.write(padding.data(), padding.size());
+    for (const auto &commOps : commOpLists)
+        for (const auto &op : commOps) {
+            ProfileOpRecord record{op.StartTimeInGroup, op.MessageSize, static_cast<std::uint32_t>(op.OpType), 0};
+            file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+        }
+    return file.good();
 }
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "job.hpp"
-#include <mutex>
-#include <nlohmann/json.hpp>
-#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
 class DurationCaculator {
@@ -18,11 +19,61 @@ public:
     double operator()(CommOp::Type opType, unsigned long long messageSize, bool useSharp, unsigned int hostCount) const;
 };
 
-class ModelInfoProvider {
+// The models loaded once and never changed, keyed by their file name without extension, e.g. "opt-125m-4". Models
+// are loaded from JSON files or from a binary profile file, whose layout is described in data.cpp. Lookups
+// take no lock. The timing of a model is built on the first lookup with each number of hosts, following the duration
+// model of the registry, so registries of different duration models can be used at the same time.
+class ModelRegistry {
 private:
-    inline static std::mutex m_CacheMtx;
-    inline static std::unordered_map<const char *, nlohmann::json> m_ModelInfoCache;
+    struct Model {
+        std::string Name;
+        double GpuSpeedupRatio;
+        std::shared_ptr<const std::vector<CommOpGroup>> CommOpGroups;
+        // Indexed by the number of hosts, published once by whichever lookup builds it first.
+        std::unique_ptr<std::atomic<const JobModel *>[]> JobModels;
+    };
+    struct State {
+        std::vector<Model> Models; // Sorted by name and GPU speedup ratio
+        unsigned int MaxHostCount;
+        JobModel::DurationModel CalcTransmissionDuration;
+
+        ~State();
+    };
+    // Shared with the handles returned by lookups, so that jobs can outlive the registry.
+    std::shared_ptr<State> m_State;
+
+    explicit ModelRegistry(unsigned int maxHostCount, const JobModel::DurationModel &calcTransmissionDuration);
+
+    // Adds the model at every GPU speedup ratio, given its CommOps timed at a speedup ratio of 1.
+    void AddModel(std::string_view name, double duration, const std::vector<CommOp> &commOps,
+                  const std::vector<double> &gpuSpeedupRatios);
+    void SortModels();
+    // Returns the model, nullptr if not loaded.
+    const Model *FindModel(std::string_view name, double gpuSpeedupRatio) const;
+    // Returns the model, throws std::runtime_error if not loaded.
+    const Model &GetModel(std::string_view name, double gpuSpeedupRatio) const;
 
 public:
-    static std::vector<CommOpGroup> GetModelInfo(const char *modelName, double gpuSpeedupRatio);
+    // Loads every model file in the JSON format at every GPU speedup ratio.
+    explicit ModelRegistry(const std::vector<const char *> &modelInfoPaths, const std::vector<double> &gpuSpeedupRatios,
+                           unsigned int maxHostCount, const JobModel::DurationModel &calcTransmissionDuration);
+    // Loads every model in a binary profile file written by ConvertProfiles at every GPU speedup ratio. The file is
+    // memory-mapped and read in place, throws std::runtime_error if it is missing or malformed.
+    explicit ModelRegistry(const char *profilePath, const std::vector<double> &gpuSpeedupRatios,
+                           unsigned int maxHostCount, const JobModel::DurationModel &calcTransmissionDuration);
+
+    // Returns whether the model is loaded at the GPU speedup ratio.
+    bool Contains(std::string_view name, double gpuSpeedupRatio) const;
+    unsigned int GetMaxHostCount() const { return m_State->MaxHostCount; }
+    // Throw std::runtime_error if the model is not loaded at the GPU speedup ratio, or if the number of hosts is more
+    // than the maximum.
+    std::shared_ptr<const std::vector<CommOpGroup>> GetCommOpGroups(std::string_view name,
+                                                                    double gpuSpeedupRatio) const;
+    std::shared_ptr<const JobModel> GetJobModel(std::string_view name, double gpuSpeedupRatio,
+                                                unsigned int hostCount) const;
+
+    // Returns the name of the model in the file, i.e. the file name without directory and extension.
+    static std::string_view GetModelName(std::string_view modelInfoPath);
+    // Converts model files in the JSON format into one binary profile file. Returns whether it succeeded.
+    static bool ConvertProfiles(const std::vector<const char *> &modelInfoPaths, const char *profilePath);
 };
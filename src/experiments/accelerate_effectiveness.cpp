@@ -2,15 +2,17 @@
 
 void TestAccelerateEffectiveness() {
     std::unordered_map<std::string, std::vector<std::pair<double, double>>> result;
+    SetDurationModel(DurationCaculator(1e8, 1.0, 0.0));
     for (double bandwidth = 1e8; bandwidth <= 20e9; bandwidth += 1e8) {
-        Job::CalcTransmissionDuration = DurationCaculator(bandwidth, 1.0, 0.0);
+        // The models are loaded once, and only their timing follows the bandwidth
+        DurationCaculator calcTransmissionDuration(bandwidth, 1.0, 0.0);
         for (auto model : ModelListBs4) {
-            Job job(2, 1, ModelInfoProvider::GetModelInfo(model, 1.0));
-            result[model].emplace_back(bandwidth, job.StepDurationWithoutSharp);
+            JobModel jobModel(LoadedModels->GetCommOpGroups(model, 1.0), 2, calcTransmissionDuration);
+            result[model].emplace_back(bandwidth, jobModel.StepDurationWithoutSharp);
         }
         for (auto model : ModelListBs16) {
-            Job job(2, 1, ModelInfoProvider::GetModelInfo(model, 1.0));
-            result[model].emplace_back(bandwidth, job.StepDurationWithoutSharp);
+            JobModel jobModel(LoadedModels->GetCommOpGroups(model, 1.0), 2, calcTransmissionDuration);
+            result[model].emplace_back(bandwidth, jobModel.StepDurationWithoutSharp);
         }
     }
     nlohmann::json jsonResult = result;
@@ -0,0 +1,64 @@
+#include "experiments.hpp"
+#include "workload.hpp"
+#include <chrono>
+#include <filesystem>
+
+static std::unique_ptr<MinaAllocationController> CreateController(FatTree &topology, const char *tracePath) {
+    FatTreeResource resources(topology, std::nullopt, 1);
+    auto controller = std::make_unique<MinaAllocationController>(
+        std::move(resources), CreateWorkloadJobSource(tracePath, *LoadedModels, 1.0), SmartHostAllocationPolicy(0.5),
+        SmartTreeBuildingPolicy(5), SmartSharingPolicy());
+    controller->EnableFastForward = true;
+    controller->EnablePeriodSkipping = true;
+    return controller;
+}
+
+void TestCheckpoint(const char *tracePath) {
+    SetDurationModel(DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    const double warmUpTime = 100.0;
+    FatTree topology(16);
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up once, and go on from the same controller as a cold run would
+    auto controller = CreateController(topology, tracePath);
+    auto startTime = Clock::now();
+    controller->RunSimulation(warmUpTime, false);
+    std::chrono::duration<double> warmUpDuration = Clock::now() - startTime;
+    startTime = Clock::now();
+    {
+        std::ofstream file("checkpoint.bin", std::ios::binary);
+        controller->SaveCheckpoint(file);
+    }
+    std::chrono::duration<double> saveDuration = Clock::now() - startTime;
+    startTime = Clock::now();
+    auto result1 = controller->RunSimulation(std::nullopt, false);
+    std::chrono::duration<double> restDuration = Clock::now() - startTime;
+    controller.reset();
+
+    // Warm-start a new controller from the checkpoint, which also restores the random streams of the policies
+    controller = CreateController(topology, tracePath);
+    startTime = Clock::now();
+    {
+        std::ifstream file("checkpoint.bin", std::ios::binary);
+        controller->LoadCheckpoint(file);
+    }
+    std::chrono::duration<double> loadDuration = Clock::now() - startTime;
+    auto result2 = controller->RunSimulation(std::nullopt, false);
+
+    // The times spent in the policies are measured rather than simulated, so they are left out
+    auto isIdentical = result1.FinishedJobCount == result2.FinishedJobCount &&
+                       result1.SimulatedTime == result2.SimulatedTime && result1.TotalJCT == result2.TotalJCT &&
+                       result1.TotalSharpTime == result2.TotalSharpTime &&
+                       result1.TotalHostTime == result2.TotalHostTime &&
+                       result1.TotalQueueingDelay == result2.TotalQueueingDelay &&
+                       result1.TreeMigrationCount == result2.TreeMigrationCount &&
+                       result1.EventCount == result2.EventCount;
+    std::cout << std::setprecision(6) << std::fixed;
+    std::cout << "Checkpoint at " << warmUpTime << "s: " << std::filesystem::file_size("checkpoint.bin")
+              << " bytes, saved in " << saveDuration.count() * 1000 << "ms, loaded in " << loadDuration.count() * 1000
+              << "ms\n";
+    std::cout << "Warm-up " << warmUpDuration.count() << "s, rest of the run " << restDuration.count() << "s\n";
+    std::cout << "Results of the warm-started run are " << (isIdentical ? "identical" : "different") << ": JCT score "
+              << result2.JCTScore << ", SHARP ratio " << result2.SharpRatio << ", makespan " << result2.SimulatedTime
+              << "s\n";
+}
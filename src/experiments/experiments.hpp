@@ -8,14 +8,16 @@
 #include "sharing_policies/greedy.hpp"
 #include "sharing_policies/non_sharp.hpp"
 #include "sharing_policies/smart.hpp"
+#include "specialized_controllers.hpp"
 #include "tree_building_policies/first.hpp"
 #include "tree_building_policies/random.hpp"
 #include "tree_building_policies/smart.hpp"
 #include "utils/graph.hpp"
-#include "utils/parallel.hpp"
 #include "utils/trace.hpp"
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iomanip>
@@ -58,6 +60,43 @@ inline static std::vector<std::vector<std::pair<unsigned int, unsigned int>>> Ho
     {{8, 26464}, {16, 67247}, {32, 6241}, {48, 45}},
 };
 
+// The models of the experiments under the duration model set by SetDurationModel.
+inline std::unique_ptr<ModelRegistry> LoadedModels;
+inline static const unsigned int MaxJobHostCount = 128;
+
+// The binary profile of AllModelList written by convert-profiles, which is loaded instead of the JSON files if present
+// and up to date.
+inline static const char *ModelProfilePath = "../data/models.bin";
+
+// Returns the models of the experiments under the duration model. The binary profile is used only if it is newer than
+// every JSON file present and has every model of AllModelList, and the JSON files are loaded with a warning otherwise.
+inline std::unique_ptr<ModelRegistry> LoadModels(const JobModel::DurationModel &calcTransmissionDuration) {
+    std::vector gpuSpeedupRatios = {1.0, 1.5};
+    if (std::filesystem::exists(ModelProfilePath)) {
+        auto profileTime = std::filesystem::last_write_time(ModelProfilePath);
+        auto isStale = std::any_of(AllModelList.cbegin(), AllModelList.cend(), [profileTime](const char *path) {
+            return std::filesystem::exists(path) && std::filesystem::last_write_time(path) > profileTime;
+        });
+        if (!isStale) {
+            auto models = std::make_unique<ModelRegistry>(ModelProfilePath, gpuSpeedupRatios, MaxJobHostCount,
+                                                          calcTransmissionDuration);
+            auto isMissing = [&models](const char *path) {
+                return !models->Contains(ModelRegistry::GetModelName(path), 1.0);
+            };
+            if (std::none_of(AllModelList.cbegin(), AllModelList.cend(), isMissing))
+                return models;
+        }
+        std::cerr << "Ignoring " << ModelProfilePath
+                  << ", which is older than the model files or misses some models. Rerun convert-profiles to update it."
+                  << std::endl;
+    }
+    return std::make_unique<ModelRegistry>(AllModelList, gpuSpeedupRatios, MaxJobHostCount, calcTransmissionDuration);
+}
+
+inline void SetDurationModel(const JobModel::DurationModel &calcTransmissionDuration) {
+    LoadedModels = LoadModels(calcTransmissionDuration);
+}
+
 void TestTreeConflicts();
 void TestLargeScaleSimulation();
 void TestAblationStudy();
@@ -66,3 +105,12 @@ void TestTreeBuilding();
 void TestJobPlacement();
 void TestAccelerateEffectiveness();
 void TestSharingOverhead();
+void TestParallelScaling();
+void TestPolicySpecialization();
+void TestTraceOverhead();
+// Replays the jobs of a cluster trace in the format read by WorkloadReader at their submit times.
+void TestWorkloadReplay(const char *tracePath);
+// Warms up the replay of a cluster trace, saves a checkpoint, and checks that a run warm-started from it is the same.
+void TestCheckpoint(const char *tracePath);
+// Forks the baseline replaying a cluster trace into other policies, and compares them over the same window.
+void TestWhatIf(const char *tracePath);
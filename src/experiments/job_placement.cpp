@@ -1,66 +1,17 @@
 #include "experiments.hpp"
-
-static SimulationResult Simulate(const FatTree &topology,
-                                 AllocationController::HostAllocationPolicy &&hostAllocationPolicy) {
-    std::vector<unsigned int> hostCountList, weightList;
-    for (auto [hostCount, weight] : HostCountTraces[0]) {
-        hostCountList.push_back(hostCount);
-        weightList.push_back(weight);
-    }
-    FatTreeResource resources(topology, std::nullopt, 1);
-    unsigned int jobCount = 0;
-    auto getNextJob = [hostCountList, weightList, &jobCount]() -> std::unique_ptr<Job> {
-        if (jobCount >= 2000)
-            return nullptr;
-        ++jobCount;
-        thread_local std::default_random_engine engine(42);
-        thread_local std::vector<unsigned int> stepCountList = {10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
-        std::uniform_int_distribution<std::size_t> randomModel(0, ModelList.size() - 1);
-        std::discrete_distribution<std::size_t> randomHostCount(weightList.cbegin(), weightList.cend());
-        std::uniform_int_distribution<std::size_t> randomStepCount(0, stepCountList.size() - 1);
-        auto model = ModelList[randomModel(engine)];
-        auto hostCount = hostCountList[randomHostCount(engine)];
-        auto stepCount = stepCountList[randomStepCount(engine)];
-        return std::make_unique<Job>(hostCount, stepCount, ModelInfoProvider::GetModelInfo(model, 1.0));
-    };
-    SmartTreeBuildingPolicy treeBuildingPolicy(5);
-    GreedySharingPolicy sharingPolicy;
-    AllocationController controller(std::move(resources), std::move(getNextJob), std::move(hostAllocationPolicy),
-                                    std::move(treeBuildingPolicy), std::move(sharingPolicy));
-    return controller.RunSimulation(std::nullopt, true);
-}
+#include "sweep.hpp"
 
 void TestJobPlacement() {
-    Job::CalcTransmissionDuration = DurationCaculator(12'500'000'000, 2.0, 0.000'05);
-    std::array ft = {
-        FatTree({8, 8, 16}, {1, 1, 1}), FatTree({8, 8, 16}, {1, 2, 2}), FatTree({8, 8, 16}, {1, 3, 3}),
-        FatTree({8, 8, 16}, {1, 4, 4}), FatTree({8, 8, 16}, {1, 5, 5}), FatTree({8, 8, 16}, {1, 6, 6}),
-        FatTree({8, 8, 16}, {1, 7, 7}), FatTree({8, 8, 16}, {1, 8, 8}),
+    // Fat trees with 1 to 8 up links per aggregation and core switch
+    auto topologies = nlohmann::ordered_json::array();
+    for (unsigned int i = 1; i <= 8; ++i)
+        topologies.push_back({{"down_links", {8, 8, 16}}, {"up_links", {1, i, i}}});
+    nlohmann::ordered_json grid = {
+        {"topology", topologies},
+        {"host_allocation", {"random", "first", "smart"}},
+        {"tree_building", "smart"},
     };
-    auto results = Parallel::Run<SimulationResult>([&ft] { return Simulate(ft[0], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[0], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[0], SmartHostAllocationPolicy(0.5)); },
-                                                   [&ft] { return Simulate(ft[1], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[1], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[1], SmartHostAllocationPolicy(0.5)); },
-                                                   [&ft] { return Simulate(ft[2], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[2], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[2], SmartHostAllocationPolicy(0.5)); },
-                                                   [&ft] { return Simulate(ft[3], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[3], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[3], SmartHostAllocationPolicy(0.5)); },
-                                                   [&ft] { return Simulate(ft[4], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[4], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[4], SmartHostAllocationPolicy(0.5)); },
-                                                   [&ft] { return Simulate(ft[5], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[5], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[5], SmartHostAllocationPolicy(0.5)); },
-                                                   [&ft] { return Simulate(ft[6], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[6], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[6], SmartHostAllocationPolicy(0.5)); },
-                                                   [&ft] { return Simulate(ft[7], RandomHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[7], FirstHostAllocationPolicy()); },
-                                                   [&ft] { return Simulate(ft[7], SmartHostAllocationPolicy(0.5)); });
+    auto results = SweepRunner(grid).Run("job_placement.jsonl", false);
     std::cout << std::setprecision(3) << std::fixed;
     nlohmann::json jsonResult;
     for (unsigned int i = 0; i < 8; ++i) {
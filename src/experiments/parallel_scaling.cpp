@@ -0,0 +1,42 @@
+#include "experiments.hpp"
+#include "sweep.hpp"
+#include <chrono>
+
+static SimulationResult Simulate(unsigned int workerCount) {
+    FatTree topology(16);
+    FatTreeResource resources(topology, std::nullopt, 1);
+    auto getNextJob = CreateSyntheticJobSource(*LoadedModels, 0, 2000, 42);
+    AllocationController controller(std::move(resources), std::move(getNextJob), SmartHostAllocationPolicy(0.5),
+                                    SmartTreeBuildingPolicy(5), SmartSharingPolicy());
+    controller.WorkerCount = workerCount;
+    return controller.RunSimulation(std::nullopt, false);
+}
+
+static bool IsSameResult(const SimulationResult &result1, const SimulationResult &result2) {
+    return result1.FinishedJobCount == result2.FinishedJobCount && result1.SimulatedTime == result2.SimulatedTime &&
+           result1.JCTScore == result2.JCTScore && result1.SharpRatio == result2.SharpRatio &&
+           result1.TreeMigrationCount == result2.TreeMigrationCount && result1.EventCount == result2.EventCount;
+}
+
+void TestParallelScaling() {
+    SetDurationModel(DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    auto maxWorkerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    std::optional<SimulationResult> baseResult;
+    double baseDuration = 0.0;
+    std::cout << std::setprecision(3) << std::fixed;
+    std::cout << "workers  time(s)  events/s  speedup  identical\n";
+    for (unsigned int workerCount = 1; workerCount <= std::min(64u, maxWorkerCount); workerCount *= 2) {
+        auto startTime = std::chrono::steady_clock::now();
+        auto result = Simulate(workerCount);
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+        if (!baseResult) {
+            baseResult = result;
+            baseDuration = duration.count();
+        }
+        std::cout << std::setw(7) << workerCount << std::setw(9) << duration.count() << std::setw(10)
+                  << std::setprecision(0) << result.EventCount / duration.count() << std::setprecision(3)
+                  << std::setw(9) << baseDuration / duration.count() << std::setw(11)
+                  << (IsSameResult(result, *baseResult) ? "yes" : "no") << '\n';
+    }
+}
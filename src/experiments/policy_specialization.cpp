@@ -0,0 +1,46 @@
+#include "experiments.hpp"
+#include "sweep.hpp"
+#include <chrono>
+
+template <typename TController>
+static std::pair<SimulationResult, double> Simulate(typename TController::HostAllocationPolicy &&hostAllocationPolicy,
+                                                    typename TController::TreeBuildingPolicy &&treeBuildingPolicy,
+                                                    typename TController::SharingPolicy &&sharingPolicy) {
+    FatTree topology(16);
+    FatTreeResource resources(topology, std::nullopt, 1);
+    auto getNextJob = CreateSyntheticJobSource(*LoadedModels, 0, 2000, 42);
+    TController controller(std::move(resources), std::move(getNextJob), std::move(hostAllocationPolicy),
+                           std::move(treeBuildingPolicy), std::move(sharingPolicy));
+    controller.EnableFastForward = true;
+    controller.EnablePeriodSkipping = true;
+    auto startTime = std::chrono::steady_clock::now();
+    auto result = controller.RunSimulation(std::nullopt, false);
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    return {result, duration.count()};
+}
+
+static void PrintComparison(const char *name, const std::pair<SimulationResult, double> &typeErased,
+                            const std::pair<SimulationResult, double> &specialized) {
+    const auto &[result1, duration1] = typeErased;
+    const auto &[result2, duration2] = specialized;
+    auto isSameResult = result1.SimulatedTime == result2.SimulatedTime && result1.JCTScore == result2.JCTScore &&
+                        result1.SharpRatio == result2.SharpRatio && result1.EventCount == result2.EventCount;
+    std::cout << name << ": " << std::setprecision(0) << result1.EventCount / duration1 << " -> "
+              << result2.EventCount / duration2 << " events/s, speedup " << std::setprecision(3)
+              << duration1 / duration2 << ", identical " << (isSameResult ? "yes" : "no") << '\n';
+}
+
+void TestPolicySpecialization() {
+    SetDurationModel(DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    std::cout << std::fixed;
+    PrintComparison("Mina",
+                    Simulate<AllocationController>(SmartHostAllocationPolicy(0.5), SmartTreeBuildingPolicy(5),
+                                                   SmartSharingPolicy()),
+                    Simulate<MinaAllocationController>(SmartHostAllocationPolicy(0.5), SmartTreeBuildingPolicy(5),
+                                                       SmartSharingPolicy()));
+    PrintComparison(
+        "Baseline",
+        Simulate<AllocationController>(FirstHostAllocationPolicy(), FirstTreeBuildingPolicy(), GreedySharingPolicy()),
+        Simulate<BaselineAllocationController>(FirstHostAllocationPolicy(), FirstTreeBuildingPolicy(),
+                                               GreedySharingPolicy()));
+}
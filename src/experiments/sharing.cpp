@@ -1,7 +1,7 @@
 #include "experiments.hpp"
 
 void TestSharing() {
-    Job::CalcTransmissionDuration = DurationCaculator(12'500'000'000, 1.5, 0.000'05);
+    SetDurationModel(DurationCaculator(12'500'000'000, 1.5, 0.000'05));
     FatTree topology(4);
     std::vector<std::vector<double>> resultMat(ModelList.size(), std::vector(ModelList.size(), 0.0));
     for (unsigned int modelIdx1 = 0; modelIdx1 < ModelList.size(); ++modelIdx1)
@@ -16,7 +16,7 @@ void TestSharing() {
                     return nullptr;
                 auto model = jobCount == 0 ? model1 : model2;
                 ++jobCount;
-                return std::make_unique<Job>(3, std::nullopt, ModelInfoProvider::GetModelInfo(model, 1.5));
+                return std::make_unique<Job>(std::nullopt, LoadedModels->GetJobModel(model, 1.5, 3));
             };
             FirstHostAllocationPolicy hostAllocationPolicy;
             FirstTreeBuildingPolicy treeBuildingPolicy;
@@ -0,0 +1,557 @@
+#include "sweep.hpp"
+#include "experiments.hpp"
+#include "policy_factory.hpp"
+#include "steady_state_monitor.hpp"
+#include "utils/statistics.hpp"
+#include "utils/thread_pool.hpp"
+#include "workload.hpp"
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+static const nlohmann::json DefaultSettings = {
+    {"topology", {{"k", 16}}},
+    {"node_quota", nullptr},
+    {"link_quota", 1},
+    {"host_allocation", "first"},
+    {"tree_building", "first"},
+    {"sharing", "greedy"},
+    {"workload", {{"host_count_trace", 0}, {"job_count", 2000}}},
+    {"seed", 42},
+    {"duration_model", {{"bandwidth", 12'500'000'000.0}, {"sharp_acc_ratio", 2.0}, {"latency", 0.000'05}}},
+    {"fast_forward", false},
+    {"period_skipping", false},
+    {"steady_state", nullptr},
+};
+
+// The parameters of a steady-state monitor and their defaults.
+static const nlohmann::json DefaultSteadyState = {
+    {"batch_duration", 1.0},
+    {"relative_tolerance", 0.05},
+    {"confidence", 0.95},
+    {"min_groups", 10},
+};
+
+static DurationCaculator CreateDurationModel(const nlohmann::json &spec) {
+    const auto &defaults = DefaultSettings["duration_model"];
+    if (!spec.is_object())
+        throw std::runtime_error("Unknown duration model " + spec.dump());
+    for (const auto &param : spec.items())
+        if (!defaults.contains(param.key()))
+            throw std::runtime_error("Unknown duration model parameter " + param.key());
+    // The parameters not given keep their defaults
+    return DurationCaculator(spec.value("bandwidth", defaults["bandwidth"].get<double>()),
+                             spec.value("sharp_acc_ratio", defaults["sharp_acc_ratio"].get<double>()),
+                             spec.value("latency", defaults["latency"].get<double>()));
+}
+
+// Returns nullptr if the spec is null, which runs the simulation to its end.
+static std::unique_ptr<SteadyStateMonitor> CreateSteadyStateMonitor(const nlohmann::json &spec) {
+    if (spec.is_null())
+        return nullptr;
+    if (!spec.is_object())
+        throw std::runtime_error("Steady state must be null or an object: " + spec.dump());
+    for (const auto &param : spec.items())
+        if (!DefaultSteadyState.contains(param.key()))
+            throw std::runtime_error("Unknown steady state parameter " + param.key());
+    auto params = DefaultSteadyState;
+    params.update(spec);
+    auto monitor = std::make_unique<SteadyStateMonitor>();
+    monitor->BatchDuration = params["batch_duration"].get<double>();
+    monitor->RelativeTolerance = params["relative_tolerance"].get<double>();
+    monitor->Confidence = params["confidence"].get<double>();
+    monitor->MinGroupCount = params["min_groups"].get<unsigned int>();
+    if (!(monitor->BatchDuration > 0.0) || !(monitor->RelativeTolerance >= 0.0) ||
+        !(monitor->Confidence > 0.0 && monitor->Confidence < 1.0))
+        throw std::runtime_error("Invalid steady state parameters " + spec.dump());
+    return monitor;
+}
+
+static nlohmann::json ToJson(const SteadyStateMonitor::Report &report) {
+    nlohmann::json estimates;
+    for (unsigned int i = 0; i < SteadyStateMonitor::MetricCount; ++i)
+        estimates[SteadyStateMonitor::MetricNames[i]] = {
+            {"mean", report.Estimates[i].Mean},
+            {"half_width", report.Estimates[i].HalfWidth},
+        };
+    return {
+        {"converged", report.IsConverged},
+        {"batch_count", report.BatchCount},
+        {"truncated_batch_count", report.TruncatedBatchCount},
+        {"warm_up_time", report.WarmUpTime},
+        {"estimates", std::move(estimates)},
+    };
+}
+
+static std::optional<unsigned int> GetQuota(const nlohmann::json &value) {
+    return value.is_null() ? std::nullopt : std::optional(value.get<unsigned int>());
+}
+
+static std::unique_ptr<FatTree> CreateTopology(const nlohmann::json &spec) {
+    if (spec.contains("k"))
+        return std::make_unique<FatTree>(spec["k"].get<unsigned int>());
+    if (spec.contains("down_links") && spec.contains("up_links"))
+        return std::make_unique<FatTree>(spec["down_links"].get<std::array<unsigned int, FatTree::Height>>(),
+                                         spec["up_links"].get<std::array<unsigned int, FatTree::Height>>());
+    throw std::runtime_error("Unknown topology " + spec.dump());
+}
+
+std::function<std::unique_ptr<Job>()> CreateSyntheticJobSource(const ModelRegistry &models,
+                                                               unsigned int hostCountTraceId, unsigned int jobCount,
+                                                               unsigned int seed) {
+    if (hostCountTraceId >= HostCountTraces.size())
+        throw std::runtime_error("Unknown host count trace " + std::to_string(hostCountTraceId));
+    std::vector<unsigned int> hostCountList, weightList;
+    for (auto [hostCount, weight] : HostCountTraces[hostCountTraceId]) {
+        hostCountList.push_back(hostCount);
+        weightList.push_back(weight);
+    }
+    return [models, hostCountList, weightList, jobCount, seed, takenJobCount = 0u]() mutable -> std::unique_ptr<Job> {
+        if (takenJobCount >= jobCount)
+            return nullptr;
+        auto engine = CreateRandomEngine(seed, RandomSubsystem::Workload, takenJobCount++);
+        static const std::vector<unsigned int> stepCountList = {10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
+        std::uniform_int_distribution<std::size_t> randomModel(0, ModelList.size() - 1);
+        std::discrete_distribution<std::size_t> randomHostCount(weightList.cbegin(), weightList.cend());
+        std::uniform_int_distribution<std::size_t> randomStepCount(0, stepCountList.size() - 1);
+        auto model = ModelList[randomModel(engine)];
+        auto hostCount = hostCountList[randomHostCount(engine)];
+        auto stepCount = stepCountList[randomStepCount(engine)];
+        return std::make_unique<Job>(stepCount, models.GetJobModel(model, 1.0, hostCount));
+    };
+}
+
+static std::function<std::unique_ptr<Job>()> CreateJobSource(const nlohmann::json &spec, const ModelRegistry &models,
+                                                             unsigned int seed) {
+    if (spec.contains("trace"))
+        return CreateWorkloadJobSource(spec["trace"].get<std::string>(), models, 1.0);
+    return CreateSyntheticJobSource(models, spec.value("host_count_trace", 0u), spec.value("job_count", 2000u), seed);
+}
+
+// Fails on unknown policies and duration models, and loads the models under the duration model if not loaded yet.
+static void CheckSettings(const nlohmann::json &settings, ModelsByDurationModel &models) {
+    CreateHostAllocationPolicy(settings["host_allocation"]);
+    CreateTreeBuildingPolicy(settings["tree_building"]);
+    CreateSharingPolicy(settings["sharing"]);
+    CreateSteadyStateMonitor(settings["steady_state"]);
+    auto &registry = models[settings["duration_model"].dump()];
+    if (!registry)
+        registry = LoadModels(CreateDurationModel(settings["duration_model"]));
+}
+
+// Sets the report of the steady-state monitor if the settings have one, or null, and the times of the setup and the
+// simulation if given.
+static SimulationResult Simulate(const nlohmann::json &settings, const ModelsByDurationModel &modelsByDurationModel,
+                                 nlohmann::json &steadyStateReport, RunTimes *times = nullptr) {
+    auto startTime = std::chrono::steady_clock::now();
+    const auto &models = *modelsByDurationModel.at(settings["duration_model"].dump());
+    auto seed = settings["seed"].get<unsigned int>();
+    auto topology = CreateTopology(settings["topology"]);
+    FatTreeResource resources(*topology, GetQuota(settings["node_quota"]), GetQuota(settings["link_quota"]));
+    AllocationController controller(
+        std::move(resources), CreateJobSource(settings["workload"], models, seed),
+        CreateHostAllocationPolicy(settings["host_allocation"]), CreateTreeBuildingPolicy(settings["tree_building"]),
+        CreateSharingPolicy(settings["sharing"]));
+    controller.GetContext().Seed = seed;
+    controller.EnableFastForward = settings["fast_forward"].get<bool>();
+    controller.EnablePeriodSkipping = settings["period_skipping"].get<bool>();
+    auto monitor = CreateSteadyStateMonitor(settings["steady_state"]);
+    controller.SteadyState = monitor.get();
+    auto simulationStartTime = std::chrono::steady_clock::now();
+    auto result = controller.RunSimulation(std::nullopt, false);
+    if (times) {
+        std::chrono::duration<double> simulationTime = std::chrono::steady_clock::now() - simulationStartTime;
+        times->Setup = std::chrono::duration<double>(simulationStartTime - startTime).count();
+        times->Simulation = simulationTime.count();
+    }
+    steadyStateReport = monitor ? ToJson(monitor->GetReport()) : nlohmann::json();
+    return result;
+}
+
+nlohmann::json ToJson(const SimulationResult &result) {
+    return {
+        {"FinishedJobCount", result.FinishedJobCount},
+        {"SimulatedTime", result.SimulatedTime},
+        {"ClusterUtilization", result.ClusterUtilization},
+        {"JCTScore", result.JCTScore},
+        {"SharpRatio", result.SharpRatio},
+        {"SharpUtilization", result.SharpUtilization},
+        {"TotalHostTime", result.TotalHostTime},
+        {"TotalJCT", result.TotalJCT},
+        {"TotalJCTWithSharp", result.TotalJCTWithSharp},
+        {"TotalJCTWithoutSharp", result.TotalJCTWithoutSharp},
+        {"TotalSharpTime", result.TotalSharpTime},
+        {"TotalSharpUsage", result.TotalSharpUsage},
+        {"TimeCostHostAllocation", result.TimeCostHostAllocation},
+        {"TimeCostTreeBuilding", result.TimeCostTreeBuilding},
+        {"TreeMigrationCount", result.TreeMigrationCount},
+        {"SharpEnabledJobCount", result.SharpEnabledJobCount},
+        {"ConsensusFrequency", result.ConsensusFrequency},
+        {"EventCount", result.EventCount},
+        {"AllocatedJobCount", result.AllocatedJobCount},
+        {"TotalQueueingDelay", result.TotalQueueingDelay},
+        {"MaxQueueingDelay", result.MaxQueueingDelay},
+        {"AverageQueueingDelay", result.AverageQueueingDelay},
+    };
+}
+
+template <typename T>
+static void ReadField(const nlohmann::json &json, const char *key, T &value) {
+    // NaN is written as null
+    const auto &field = json.at(key);
+    value = field.is_null() ? std::numeric_limits<T>::quiet_NaN() : field.get<T>();
+}
+
+static SimulationResult FromJson(const nlohmann::json &json) {
+    SimulationResult result;
+    ReadField(json, "FinishedJobCount", result.FinishedJobCount);
+    ReadField(json, "SimulatedTime", result.SimulatedTime);
+    ReadField(json, "ClusterUtilization", result.ClusterUtilization);
+    ReadField(json, "JCTScore", result.JCTScore);
+    ReadField(json, "SharpRatio", result.SharpRatio);
+    ReadField(json, "SharpUtilization", result.SharpUtilization);
+    ReadField(json, "TotalHostTime", result.TotalHostTime);
+    ReadField(json, "TotalJCT", result.TotalJCT);
+    ReadField(json, "TotalJCTWithSharp", result.TotalJCTWithSharp);
+    ReadField(json, "TotalJCTWithoutSharp", result.TotalJCTWithoutSharp);
+    ReadField(json, "TotalSharpTime", result.TotalSharpTime);
+    ReadField(json, "TotalSharpUsage", result.TotalSharpUsage);
+    ReadField(json, "TimeCostHostAllocation", result.TimeCostHostAllocation);
+    ReadField(json, "TimeCostTreeBuilding", result.TimeCostTreeBuilding);
+    ReadField(json, "TreeMigrationCount", result.TreeMigrationCount);
+    ReadField(json, "SharpEnabledJobCount", result.SharpEnabledJobCount);
+    ReadField(json, "ConsensusFrequency", result.ConsensusFrequency);
+    ReadField(json, "EventCount", result.EventCount);
+    ReadField(json, "AllocatedJobCount", result.AllocatedJobCount);
+    ReadField(json, "TotalQueueingDelay", result.TotalQueueingDelay);
+    ReadField(json, "MaxQueueingDelay", result.MaxQueueingDelay);
+    ReadField(json, "AverageQueueingDelay", result.AverageQueueingDelay);
+    return result;
+}
+
+// Appends the runs of one grid object, a setting at a time from the first.
+static void ExpandGrid(const nlohmann::ordered_json &grid, nlohmann::ordered_json::const_iterator setting,
+                       nlohmann::json &settings, std::vector<nlohmann::json> &runs) {
+    if (setting == grid.cend()) {
+        runs.push_back(settings);
+        return;
+    }
+    if (!DefaultSettings.contains(setting.key()))
+        throw std::runtime_error("Unknown sweep setting " + setting.key());
+    auto next = std::next(setting);
+    if (!setting->is_array()) {
+        settings[setting.key()] = *setting;
+        ExpandGrid(grid, next, settings, runs);
+        return;
+    }
+    for (const auto &value : *setting) {
+        settings[setting.key()] = value;
+        ExpandGrid(grid, next, settings, runs);
+    }
+}
+
+SimulationResult RunTimed(const nlohmann::json &settings, RunTimes &times) {
+    auto fullSettings = DefaultSettings;
+    for (const auto &[key, value] : settings.items()) {
+        if (!DefaultSettings.contains(key))
+            throw std::runtime_error("Unknown sweep setting " + key);
+        if (value.is_array())
+            throw std::runtime_error("Setting " + key + " of a single run must not be a list");
+        fullSettings[key] = value;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    ModelsByDurationModel models;
+    CheckSettings(fullSettings, models);
+    times.LoadModels = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    nlohmann::json steadyStateReport;
+    return Simulate(fullSettings, models, steadyStateReport, &times);
+}
+
+SweepRunner::SweepRunner(const nlohmann::ordered_json &grid) {
+    for (const auto &subgrid : grid.is_array() ? grid : nlohmann::ordered_json::array({grid})) {
+        if (!subgrid.is_object())
+            throw std::runtime_error("Sweep grid must be an object or an array of objects");
+        auto settings = DefaultSettings;
+        ExpandGrid(subgrid, subgrid.cbegin(), settings, m_Runs);
+    }
+    // Fail before anything is run, and load the models once for each duration model
+    for (const auto &settings : m_Runs)
+        CheckSettings(settings, m_Models);
+}
+
+std::vector<SimulationResult> SweepRunner::Run(const std::string &outputPath, bool resume) const {
+    std::vector<SimulationResult> results(m_Runs.size());
+    std::vector<unsigned int> pendingRuns;
+    std::vector<std::string> finishedLines;
+    if (resume) {
+        // The settings serialize the same whatever order they were given in, as the keys are sorted
+        std::unordered_map<std::string, nlohmann::json> finishedResults;
+        std::ifstream file(outputPath);
+        std::string line;
+        while (std::getline(file, line)) {
+            // A line cut short by an interrupted write is dropped and run again
+            auto data = nlohmann::json::parse(line, nullptr, false);
+            if (data.is_discarded() || !data.contains("settings") || !data.contains("result"))
+                continue;
+            finishedResults[data["settings"].dump()] = data["result"];
+            finishedLines.push_back(line);
+        }
+        for (unsigned int i = 0; i < m_Runs.size(); ++i) {
+            auto iter = finishedResults.find(m_Runs[i].dump());
+            if (iter == finishedResults.cend())
+                pendingRuns.push_back(i);
+            else
+                results[i] = FromJson(iter->second);
+        }
+    } else
+        for (unsigned int i = 0; i < m_Runs.size(); ++i)
+            pendingRuns.push_back(i);
+    // Only the valid lines are kept, so that nothing is appended to a partial line
+    std::ofstream file(outputPath);
+    if (!file)
+        throw std::runtime_error("Cannot open " + outputPath);
+    for (const auto &line : finishedLines)
+        file << line << '\n';
+    file.flush();
+
+    std::mutex mutex;
+    std::vector<std::string> errors(m_Runs.size());
+    unsigned int finishedRunCount = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    auto showProgress = [this, &pendingRuns, &finishedRunCount, startTime](bool last) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        auto doneRunCount = m_Runs.size() - pendingRuns.size() + finishedRunCount;
+        std::cout << std::setprecision(1) << std::fixed;
+        std::cout << "\rSweep progress: " << doneRunCount << " / " << m_Runs.size() << " runs, " << elapsed.count()
+                  << "s elapsed";
+        if (finishedRunCount && finishedRunCount < pendingRuns.size())
+            std::cout << ", about " << elapsed.count() / finishedRunCount * (pendingRuns.size() - finishedRunCount)
+                      << "s left";
+        std::cout << (last ? "\n" : "   ") << std::flush;
+    };
+    if (ShowProgress)
+        showProgress(false);
+    ThreadPool threadPool(std::clamp<unsigned int>(pendingRuns.size(), 1, WorkerCount));
+    threadPool.ParallelFor(
+        pendingRuns.size(),
+        [this, &pendingRuns, &results, &errors, &mutex, &file, &finishedRunCount, &showProgress](unsigned int i) {
+            auto runIdx = pendingRuns[i];
+            std::string error;
+            nlohmann::json steadyStateReport;
+            try {
+                results[runIdx] = Simulate(m_Runs[runIdx], m_Models, steadyStateReport);
+            } catch (const std::exception &e) {
+                error = e.what();
+            }
+            nlohmann::json line = {{"settings", m_Runs[runIdx]}, {"result", ToJson(results[runIdx])}};
+            if (!steadyStateReport.is_null())
+                line["steady_state"] = std::move(steadyStateReport);
+            std::lock_guard lock(mutex);
+            // A failed run is left out of the file, so that resuming runs it again
+            if (error.empty())
+                file << line.dump() << std::endl;
+            else
+                errors[runIdx] = std::move(error);
+            ++finishedRunCount;
+            if (ShowProgress)
+                showProgress(false);
+        },
+        1);
+    if (ShowProgress)
+        showProgress(true);
+    for (unsigned int i = 0; i < errors.size(); ++i)
+        if (!errors[i].empty())
+            throw std::runtime_error("Run " + std::to_string(i) + " of the sweep failed: " + errors[i]);
+    return results;
+}
+
+// Returns the value of every field of the result by name, with NaN for those not defined.
+static std::vector<std::pair<std::string, double>> GetMetrics(const SimulationResult &result) {
+    std::vector<std::pair<std::string, double>> metrics;
+    auto fields = ToJson(result);
+    for (const auto &field : fields.items())
+        metrics.emplace_back(field.key(), field.value().get<double>());
+    return metrics;
+}
+
+static double GetMetric(const SimulationResult &result, const std::string &name) {
+    return ToJson(result).at(name).get<double>();
+}
+
+ReplicationRunner::ReplicationRunner(const nlohmann::json &replication) {
+    static const nlohmann::json DefaultOptions = {
+        {"scenario", nlohmann::json::object()},
+        {"configurations", {nlohmann::json::object()}},
+        {"target_metric", "JCTScore"},
+        {"tolerance", nullptr},
+        {"confidence", 0.95},
+        {"min_replicas", 5},
+        {"max_replicas", 100},
+    };
+    if (!replication.is_object())
+        throw std::runtime_error("Replication must be an object");
+    for (const auto &option : replication.items())
+        if (!DefaultOptions.contains(option.key()))
+            throw std::runtime_error("Unknown replication option " + option.key());
+    auto options = DefaultOptions;
+    options.update(replication);
+    m_TargetMetric = options["target_metric"].get<std::string>();
+    if (!ToJson(SimulationResult()).contains(m_TargetMetric))
+        throw std::runtime_error("Unknown metric " + m_TargetMetric);
+    if (!options["tolerance"].is_null())
+        m_Tolerance = options["tolerance"].get<double>();
+    m_Confidence = options["confidence"].get<double>();
+    m_MinReplicaCount = options["min_replicas"].get<unsigned int>();
+    m_MaxReplicaCount = options["max_replicas"].get<unsigned int>();
+    if (!(m_Confidence > 0.0 && m_Confidence < 1.0) || (m_Tolerance && !(*m_Tolerance > 0.0)) ||
+        m_MinReplicaCount < 2 || m_MaxReplicaCount < m_MinReplicaCount)
+        throw std::runtime_error("Invalid replication options " + replication.dump());
+
+    const auto &scenario = options["scenario"];
+    if (!scenario.is_object() || !options["configurations"].is_array() || options["configurations"].empty())
+        throw std::runtime_error("Replication needs a scenario object and a non-empty array of configurations");
+    for (const auto &configuration : options["configurations"]) {
+        if (!configuration.is_object() || configuration.contains("seed"))
+            throw std::runtime_error("Configuration must be an object without seed: " + configuration.dump());
+        auto settings = DefaultSettings;
+        for (const auto *changes : {&scenario, &configuration})
+            for (const auto &setting : changes->items()) {
+                if (!DefaultSettings.contains(setting.key()))
+                    throw std::runtime_error("Unknown replication setting " + setting.key());
+                if (setting.value().is_array())
+                    throw std::runtime_error("Replication setting " + setting.key() + " cannot be a list");
+                settings[setting.key()] = setting.value();
+            }
+        CheckSettings(settings, m_Models);
+        m_Configurations.push_back(std::move(settings));
+    }
+}
+
+bool ReplicationRunner::IsPrecise(const std::vector<std::vector<SimulationResult>> &results,
+                                  unsigned int replicaCount) const {
+    for (unsigned int configurationIdx = 0; configurationIdx < m_Configurations.size(); ++configurationIdx) {
+        std::vector<double> values;
+        for (unsigned int replicaIdx = 0; replicaIdx < replicaCount; ++replicaIdx)
+            values.push_back(GetMetric(results[replicaIdx][configurationIdx], m_TargetMetric));
+        if (!(CalcInterval(values, m_Confidence).HalfWidth <= *m_Tolerance))
+            return false;
+    }
+    return true;
+}
+
+nlohmann::json ReplicationRunner::Run() const {
+    auto configurationCount = m_Configurations.size();
+    std::vector<std::vector<SimulationResult>> results(m_MaxReplicaCount,
+                                                       std::vector<SimulationResult>(configurationCount));
+    std::vector<unsigned int> finishedRunCounts(m_MaxReplicaCount);
+    std::mutex mutex;
+    std::atomic<bool> isStopped = false;
+    unsigned int replicaCount = 0;
+    bool isPrecise = false;
+    std::string error;
+    auto startTime = std::chrono::steady_clock::now();
+    auto showProgress = [this, &results, &replicaCount, startTime](bool last) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        std::cout << "\rReplication progress: " << replicaCount << " replicas, " << std::setprecision(1) << std::fixed
+                  << elapsed.count() << "s elapsed";
+        if (replicaCount >= 2) {
+            double maxHalfWidth = 0.0;
+            for (unsigned int configurationIdx = 0; configurationIdx < m_Configurations.size(); ++configurationIdx) {
+                std::vector<double> values;
+                for (unsigned int replicaIdx = 0; replicaIdx < replicaCount; ++replicaIdx)
+                    values.push_back(GetMetric(results[replicaIdx][configurationIdx], m_TargetMetric));
+                maxHalfWidth = std::max(maxHalfWidth, CalcInterval(values, m_Confidence).HalfWidth);
+            }
+            std::cout << ", " << m_TargetMetric << " within " << std::setprecision(6) << maxHalfWidth;
+        }
+        std::cout << (last ? "\n" : "   ") << std::flush;
+    };
+    if (ShowProgress)
+        showProgress(false);
+    // Every run of a replica is a task of its own, so the configurations of a replica run in parallel as well
+    ThreadPool threadPool(std::clamp<unsigned int>(m_MaxReplicaCount * configurationCount, 1, WorkerCount));
+    threadPool.ParallelFor(
+        m_MaxReplicaCount * configurationCount,
+        [&](unsigned int i) {
+            if (isStopped)
+                return;
+            auto replicaIdx = i / configurationCount, configurationIdx = i % configurationCount;
+            auto settings = m_Configurations[configurationIdx];
+            settings["seed"] = settings["seed"].get<unsigned int>() + replicaIdx;
+            SimulationResult result;
+            std::string runError;
+            try {
+                nlohmann::json steadyStateReport;
+                result = Simulate(settings, m_Models, steadyStateReport);
+            } catch (const std::exception &e) {
+                runError = e.what();
+            }
+            std::lock_guard lock(mutex);
+            if (!runError.empty()) {
+                if (error.empty())
+                    error = "Replica " + std::to_string(replicaIdx) + " of configuration " +
+                            std::to_string(configurationIdx) + " failed: " + runError;
+                isStopped = true;
+                return;
+            }
+            results[replicaIdx][configurationIdx] = result;
+            ++finishedRunCounts[replicaIdx];
+            // Replicas are taken in order, so that where the replication stops does not depend on the threads
+            while (!isStopped && replicaCount < m_MaxReplicaCount &&
+                   finishedRunCounts[replicaCount] == configurationCount) {
+                ++replicaCount;
+                if (m_Tolerance && replicaCount >= m_MinReplicaCount && IsPrecise(results, replicaCount))
+                    isPrecise = isStopped = true;
+            }
+            if (ShowProgress)
+                showProgress(false);
+        },
+        1);
+    if (ShowProgress)
+        showProgress(true);
+    if (!error.empty())
+        throw std::runtime_error(error);
+
+    // The intervals of every field of each configuration, and of its paired differences from the first
+    auto calcIntervals = [this, &results, replicaCount](unsigned int configurationIdx, bool isDifference) {
+        std::vector<std::vector<double>> valuesByMetric;
+        std::vector<std::string> names;
+        for (unsigned int replicaIdx = 0; replicaIdx < replicaCount; ++replicaIdx) {
+            auto metrics = GetMetrics(results[replicaIdx][configurationIdx]);
+            auto baseMetrics = GetMetrics(results[replicaIdx][0]);
+            valuesByMetric.resize(metrics.size());
+            names.clear();
+            for (unsigned int j = 0; j < metrics.size(); ++j) {
+                names.push_back(metrics[j].first);
+                valuesByMetric[j].push_back(metrics[j].second - (isDifference ? baseMetrics[j].second : 0.0));
+            }
+        }
+        nlohmann::json intervals;
+        for (unsigned int j = 0; j < names.size(); ++j) {
+            auto interval = CalcInterval(valuesByMetric[j], m_Confidence);
+            intervals[names[j]] = {
+                {"mean", interval.Mean}, {"std_dev", interval.StdDev}, {"half_width", interval.HalfWidth}};
+        }
+        return intervals;
+    };
+    nlohmann::json report = {
+        {"target_metric", m_TargetMetric},
+        {"tolerance", m_Tolerance ? nlohmann::json(*m_Tolerance) : nlohmann::json()},
+        {"confidence", m_Confidence},
+        {"replica_count", replicaCount},
+        {"is_precise", isPrecise},
+        {"configurations", nlohmann::json::array()},
+    };
+    for (unsigned int configurationIdx = 0; configurationIdx < configurationCount; ++configurationIdx) {
+        nlohmann::json configuration = {
+            {"settings", m_Configurations[configurationIdx]},
+            {"metrics", calcIntervals(configurationIdx, false)},
+        };
+        if (configurationIdx > 0)
+            configuration["differences"] = calcIntervals(configurationIdx, true);
+        report["configurations"].push_back(std::move(configuration));
+    }
+    return report;
+}
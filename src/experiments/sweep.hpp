@@ -0,0 +1,121 @@
+#pragma once
+
+#include "allocation_controller.hpp"
+#include "data.hpp"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// The models under each duration model of the runs, keyed by the duration model.
+using ModelsByDurationModel = std::unordered_map<std::string, std::unique_ptr<ModelRegistry>>;
+
+// The wall time of the phases of a run in seconds.
+struct RunTimes {
+    double LoadModels = 0.0;
+    double Setup = 0.0; // Building the topology, the job source and the controller
+    double Simulation = 0.0;
+};
+
+// Returns the closed-loop jobs of the experiments, each with a model of ModelList, a host count drawn with the
+// weights of the host count trace, and 10 to 100 steps. Each job is drawn from the workload stream of its index under
+// the seed, so any job can be regenerated alone. Throws std::runtime_error on an unknown host count trace.
+std::function<std::unique_ptr<Job>()> CreateSyntheticJobSource(const ModelRegistry &models,
+                                                               unsigned int hostCountTraceId, unsigned int jobCount,
+                                                               unsigned int seed);
+
+// Runs the settings of one run of a sweep grid, with the defaults filled in for the settings not given, on the calling
+// thread with models loaded for it alone, and times its phases. Throws std::runtime_error on an unknown setting, a
+// list of values, or an unknown policy or duration model.
+SimulationResult RunTimed(const nlohmann::json &settings, RunTimes &times);
+
+// Returns every field of the result keyed by its name.
+nlohmann::json ToJson(const SimulationResult &result);
+
+// Runs the simulations of a parameter grid on a fixed number of threads, each run taken by whichever thread is free.
+// The result of each run is appended to a JSONL file as soon as it finishes, with the settings of the run.
+//
+// A grid is an object that gives each setting a list of values, or a single value that is not a list, and its runs are
+// every combination of the values with the first setting varying slowest. An array of grids runs one after another.
+// The settings not given take their defaults:
+//   topology: {"k": 16}, or {"down_links": [...], "up_links": [...]} with a count per layer
+//   node_quota, link_quota: null and 1, where null means no quota
+//   host_allocation, tree_building, sharing: "first", "first" and "greedy", given as to CreateHostAllocationPolicy
+//   workload: {"host_count_trace": 0, "job_count": 2000}, which is the closed-loop jobs of ModelList with the host
+//     counts of HostCountTraces, or {"trace": path} for the jobs of a cluster trace at their submit times
+//   seed: 42, of the random streams of the synthetic jobs and of the policies
+//   duration_model: {"bandwidth": 12.5e9, "sharp_acc_ratio": 2.0, "latency": 5e-5}, given as to DurationCaculator,
+//     with the parameters not given at their defaults
+//   fast_forward, period_skipping: false
+//   steady_state: null, which runs to the end, or {"batch_duration": 1.0, "relative_tolerance": 0.05,
+//     "confidence": 0.95, "min_groups": 10} to stop once the steady-state estimates converge, as in SteadyStateMonitor,
+//     whose report is written with the result
+// Each run has a context of its own, so runs of different duration models and policies can share the threads.
+class SweepRunner {
+private:
+    std::vector<nlohmann::json> m_Runs;
+    ModelsByDurationModel m_Models;
+
+public:
+    unsigned int WorkerCount = std::max(1u, std::thread::hardware_concurrency());
+    // Shows the runs finished out of all and the time left, summed up over all the runs.
+    bool ShowProgress = true;
+
+    // Throws std::runtime_error on an unknown setting, policy or duration model.
+    explicit SweepRunner(const nlohmann::ordered_json &grid);
+
+    // Returns the settings of every run with the defaults filled in.
+    const std::vector<nlohmann::json> &GetRuns() const { return m_Runs; }
+    // Runs every run and returns the results in the order of GetRuns. If resume, the runs whose settings are in the
+    // output file already are not run again and their results are read from it, otherwise the file is started over.
+    // Throws std::runtime_error if any run fails, after the others have finished.
+    std::vector<SimulationResult> Run(const std::string &outputPath, bool resume) const;
+};
+
+// Runs replicas of a scenario under each of the configurations to compare, until the confidence intervals of a target
+// metric are tight enough. Replica r runs every configuration with the seed of the scenario plus r, which seeds both
+// the synthetic jobs and the policies, so the configurations are compared on the same jobs and random choices and
+// their paired differences have tighter intervals than their means.
+//
+// A replication is an object of:
+//   scenario: the settings shared by the configurations, as in a sweep grid without lists
+//   configurations: the settings that each configuration changes in the scenario except the seed, e.g.
+//     [{"sharing": "greedy"}, {"sharing": "smart"}], or the scenario alone if not given
+//   target_metric: "JCTScore", the field of SimulationResult whose intervals stop the replication
+//   tolerance: null, the half-width that the interval of the target metric of every configuration must be within
+//     to stop before max_replicas, where null runs them all
+//   confidence: 0.95, of the two-sided Student t intervals
+//   min_replicas, max_replicas: 5 and 100
+// The intervals are checked after each replica in order, so the replicas taken and the results are the same whatever
+// the number of threads.
+class ReplicationRunner {
+private:
+    std::vector<nlohmann::json> m_Configurations;
+    ModelsByDurationModel m_Models;
+    std::string m_TargetMetric;
+    std::optional<double> m_Tolerance;
+    double m_Confidence;
+    unsigned int m_MinReplicaCount;
+    unsigned int m_MaxReplicaCount;
+
+    // Returns whether the intervals of the target metric over the first replicas are within the tolerance.
+    bool IsPrecise(const std::vector<std::vector<SimulationResult>> &results, unsigned int replicaCount) const;
+
+public:
+    unsigned int WorkerCount = std::max(1u, std::thread::hardware_concurrency());
+    // Shows the replicas taken and the widest interval of the target metric.
+    bool ShowProgress = true;
+
+    // Throws std::runtime_error on an unknown setting, policy, duration model, metric or option.
+    explicit ReplicationRunner(const nlohmann::json &replication);
+
+    // Runs the replicas and returns the report, with the mean, the standard deviation and the half-width of the
+    // interval of every field of SimulationResult for each configuration, and of its paired differences from the first
+    // configuration. Throws std::runtime_error if any run fails.
+    nlohmann::json Run() const;
+};
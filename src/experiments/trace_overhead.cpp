@@ -0,0 +1,51 @@
+#include "experiments.hpp"
+#include "sweep.hpp"
+#include <chrono>
+
+static std::pair<SimulationResult, double> Simulate(Tracer *tracer) {
+    FatTree topology(16);
+    FatTreeResource resources(topology, std::nullopt, 1);
+    auto getNextJob = CreateSyntheticJobSource(*LoadedModels, 0, 500, 42);
+    MinaAllocationController controller(std::move(resources), std::move(getNextJob), SmartHostAllocationPolicy(0.5),
+                                        SmartTreeBuildingPolicy(5), SmartSharingPolicy());
+    // The events of the jobs the tracer records are run one by one, and those of the others are skipped as without it
+    controller.EnableFastForward = true;
+    controller.EnablePeriodSkipping = true;
+    controller.EventTracer = tracer;
+    auto startTime = std::chrono::steady_clock::now();
+    auto result = controller.RunSimulation(std::nullopt, false);
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    return {result, duration.count()};
+}
+
+void TestTraceOverhead() {
+    SetDurationModel(DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "Tracing compiled in: " << (Tracer::IsEnabled ? "yes" : "no") << '\n';
+    auto [result1, duration1] = Simulate(nullptr);
+    std::cout << "Without tracer: " << std::setprecision(3) << duration1 << " s, " << std::setprecision(0)
+              << result1.EventCount / duration1 << " events/s\n";
+    // The file is complete only once the tracer is destroyed, which is counted in the time
+    auto simulateTraced = [](TraceFilter &&filter) {
+        auto startTime = std::chrono::steady_clock::now();
+        SimulationResult result;
+        {
+            Tracer tracer("trace.json", std::move(filter));
+            result = Simulate(&tracer).first;
+        }
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+        return std::pair{result, duration.count()};
+    };
+    auto [result2, duration2] = simulateTraced({});
+    std::cout << "With tracer: " << std::setprecision(3) << duration2 << " s, " << std::setprecision(0)
+              << result2.EventCount / duration2 << " events/s, overhead " << std::setprecision(3)
+              << duration2 / duration1 << "x\n";
+    // A targeted trace as left on in sweeps, of 5% of the jobs and without transmissions
+    TraceFilter filter;
+    filter.JobSamplingRate = 0.05;
+    filter.KindMask &= ~TraceFilter::GetKindBit(TraceEvent::Kind::Transmission);
+    auto [result3, duration3] = simulateTraced(std::move(filter));
+    std::cout << "With filtered tracer: " << std::setprecision(3) << duration3 << " s, " << std::setprecision(0)
+              << result3.EventCount / duration3 << " events/s, overhead " << std::setprecision(3)
+              << duration3 / duration1 << "x\n";
+}
@@ -0,0 +1,63 @@
+#include "experiments.hpp"
+#include "utils/thread_pool.hpp"
+#include "workload.hpp"
+#include <chrono>
+
+void TestWhatIf(const char *tracePath) {
+    SetDurationModel(DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    const double forkTime = 100.0, windowDuration = 100.0;
+    FatTree topology(16);
+    FatTreeResource resources(topology, std::nullopt, 1);
+
+    // Run the baseline up to the fork, and continue it alongside the forks
+    AllocationController controller(std::move(resources), CreateWorkloadJobSource(tracePath, *LoadedModels, 1.0),
+                                    FirstHostAllocationPolicy(), FirstTreeBuildingPolicy(), GreedySharingPolicy());
+    controller.EnableFastForward = true;
+    controller.EnablePeriodSkipping = true;
+    auto forkResult = controller.RunSimulation(forkTime, false);
+    std::vector<const char *> names = {"Baseline", "Smart sharing", "Smart trees and sharing", "Mina"};
+    std::vector<std::unique_ptr<AllocationController>> forks;
+    auto startTime = std::chrono::steady_clock::now();
+    forks.push_back(controller.Fork(FirstHostAllocationPolicy(), FirstTreeBuildingPolicy(), SmartSharingPolicy()));
+    forks.push_back(controller.Fork(FirstHostAllocationPolicy(), SmartTreeBuildingPolicy(5), SmartSharingPolicy()));
+    forks.push_back(
+        controller.Fork(SmartHostAllocationPolicy(0.5), SmartTreeBuildingPolicy(5), SmartSharingPolicy()));
+    std::chrono::duration<double> forkDuration = std::chrono::steady_clock::now() - startTime;
+    std::vector<AllocationController *> controllers = {&controller};
+    for (const auto &fork : forks)
+        controllers.push_back(fork.get());
+    std::vector<SimulationResult> results(controllers.size());
+    ThreadPool threadPool(controllers.size());
+    threadPool.ParallelFor(controllers.size(), [&controllers, &results, forkTime, windowDuration](unsigned int i) {
+        results[i] = controllers[i]->RunSimulation(forkTime + windowDuration, false);
+    });
+
+    // The differences from the fork are what happened in the window
+    nlohmann::json jsonResult;
+    std::cout << std::setprecision(6) << std::fixed;
+    std::cout << "Forked " << forks.size() << " times in " << forkDuration.count() * 1000 << "ms at "
+              << forkResult.SimulatedTime << "s with " << forkResult.FinishedJobCount << " jobs finished:\n";
+    auto hostCount = topology.NodesByLayer[0].size();
+    for (unsigned int i = 0; i < results.size(); ++i) {
+        const auto &result = results[i];
+        auto duration = result.SimulatedTime - forkResult.SimulatedTime;
+        auto finishedJobCount = result.FinishedJobCount - forkResult.FinishedJobCount;
+        auto allocatedJobCount = result.AllocatedJobCount - forkResult.AllocatedJobCount;
+        auto utilization = (result.TotalHostTime - forkResult.TotalHostTime) / (duration * hostCount);
+        auto sharpRatio =
+            (result.TotalSharpTime - forkResult.TotalSharpTime) / (result.TotalJCT - forkResult.TotalJCT);
+        auto queueingDelay =
+            allocatedJobCount ? (result.TotalQueueingDelay - forkResult.TotalQueueingDelay) / allocatedJobCount : 0.0;
+        jsonResult.push_back({
+            {"Name", names[i]},
+            {"FinishedJobCount", finishedJobCount},
+            {"ClusterUtilization", utilization},
+            {"SharpRatio", sharpRatio},
+            {"AverageQueueingDelay", queueingDelay},
+        });
+        std::cout << names[i] << ": +" << finishedJobCount << " jobs finished, utilization " << utilization
+                  << ", SHARP ratio " << sharpRatio << ", queueing delay " << queueingDelay << "s\n";
+    }
+    std::ofstream file("what_if.json");
+    file << jsonResult;
+}
@@ -0,0 +1,50 @@
+#include "experiments.hpp"
+#include "workload.hpp"
+
+static SimulationResult Simulate(bool enableMina, const char *tracePath) {
+    FatTree topology(16);
+    FatTreeResource resources(topology, std::nullopt, 1);
+    auto getNextJob = CreateWorkloadJobSource(tracePath, *LoadedModels, 1.0);
+    AllocationController::HostAllocationPolicy hostAllocationPolicy;
+    AllocationController::TreeBuildingPolicy treeBuildingPolicy;
+    AllocationController::SharingPolicy sharingPolicy;
+    if (enableMina) {
+        hostAllocationPolicy = SmartHostAllocationPolicy(0.5);
+        treeBuildingPolicy = SmartTreeBuildingPolicy(5);
+        sharingPolicy = SmartSharingPolicy();
+    } else {
+        hostAllocationPolicy = FirstHostAllocationPolicy();
+        treeBuildingPolicy = FirstTreeBuildingPolicy();
+        sharingPolicy = GreedySharingPolicy();
+    }
+    AllocationController controller(std::move(resources), std::move(getNextJob), std::move(hostAllocationPolicy),
+                                    std::move(treeBuildingPolicy), std::move(sharingPolicy));
+    controller.EnableFastForward = true;
+    controller.EnablePeriodSkipping = true;
+    return controller.RunSimulation(std::nullopt, false);
+}
+
+void TestWorkloadReplay(const char *tracePath) {
+    SetDurationModel(DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+    std::array results = {Simulate(true, tracePath), Simulate(false, tracePath)};
+
+    nlohmann::json jsonResult;
+    for (const auto &result : results)
+        jsonResult.push_back({
+            {"JCTScore", result.JCTScore},
+            {"SharpRatio", result.SharpRatio},
+            {"ClusterUtilization", result.ClusterUtilization},
+            {"AverageQueueingDelay", result.AverageQueueingDelay},
+            {"MaxQueueingDelay", result.MaxQueueingDelay},
+        });
+    std::ofstream file("workload_replay.json");
+    file << jsonResult;
+
+    std::cout << std::setprecision(6) << std::fixed;
+    const char *names[] = {"Mina", "Baseline"};
+    for (unsigned int i = 0; i < results.size(); ++i)
+        std::cout << names[i] << ": JCT score " << results[i].JCTScore << ", SHARP ratio " << results[i].SharpRatio
+                  << ", utilization " << results[i].ClusterUtilization << ", queueing delay "
+                  << results[i].AverageQueueingDelay << "s (max " << results[i].MaxQueueingDelay << "s), makespan "
+                  << results[i].SimulatedTime << "s\n";
+}
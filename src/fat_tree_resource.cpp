@@ -1,4 +1,5 @@
 #include "fat_tree_resource.hpp"
+#include "utils/id_span_kernels.hpp"
 #include <cassert>
 
 unsigned int FatTreeResource::CalcHostFragments(bool available, unsigned int beginHostIdx, unsigned int hostCountInPod,
@@ -25,23 +26,44 @@ unsigned int FatTreeResource::CalcHostFragments(bool available, unsigned int beg
 
 FatTreeResource::FatTreeResource(const FatTree &topology, std::optional<unsigned int> nodeQuota,
                                  std::optional<unsigned int> linkQuota)
-    : m_NodeUsage(topology.Nodes.size(), 0), m_EdgeUsage(topology.Edges.size(), 0), Topology(&topology),
+    : m_NodeUsage(topology.Nodes.size(), 0), m_EdgeUsage(topology.Edges.size(), 0),
+      m_AggrTreeIndex(topology, nodeQuota && *nodeQuota < 2, linkQuota && *linkQuota < 2), Topology(&topology),
       NodeQuota(nodeQuota), LinkQuota(linkQuota) {
     assert(!NodeQuota || *NodeQuota > 0);
     assert(!LinkQuota || *LinkQuota > 0);
 }
 
+void FatTreeResource::SetUsage(std::vector<unsigned int> &&nodeUsage, std::vector<unsigned int> &&edgeUsage) {
+    assert(nodeUsage.size() == m_NodeUsage.size());
+    assert(edgeUsage.size() == m_EdgeUsage.size());
+    m_NodeUsage = std::move(nodeUsage);
+    m_EdgeUsage = std::move(edgeUsage);
+}
+
 void FatTreeResource::Allocate(const AggrTree &tree) {
     const auto &[nodes, edges] = tree;
-    for (auto node : nodes) {
-        if (node->Layer == 0)
-            continue;
-        assert(!NodeQuota || m_NodeUsage[node->ID] < *NodeQuota);
-        ++m_NodeUsage[node->ID];
+    if (NodeQuota)
+        for (auto node : nodes) {
+            if (node->Layer == 0)
+                continue;
+            assert(m_NodeUsage[node->ID] < *NodeQuota);
+            ++m_NodeUsage[node->ID];
+        }
+    if (LinkQuota)
+        for (auto edge : edges) {
+            assert(m_EdgeUsage[edge->ID] < *LinkQuota);
+            ++m_EdgeUsage[edge->ID];
+        }
+}
+
+void FatTreeResource::Allocate(const CompactAggrTree &tree) {
+    if (NodeQuota) {
+        assert(!IdSpanKernels::AnyReachesQuota(m_NodeUsage.data(), tree.GetNodeIDs(), tree.GetNodeCount(), *NodeQuota));
+        IdSpanKernels::Increment(m_NodeUsage.data(), tree.GetNodeIDs(), tree.GetNodeCount());
     }
-    for (auto edge : edges) {
-        assert(!LinkQuota || m_EdgeUsage[edge->ID] < *LinkQuota);
-        ++m_EdgeUsage[edge->ID];
+    if (LinkQuota) {
+        assert(!IdSpanKernels::AnyReachesQuota(m_EdgeUsage.data(), tree.GetEdgeIDs(), tree.GetEdgeCount(), *LinkQuota));
+        IdSpanKernels::Increment(m_EdgeUsage.data(), tree.GetEdgeIDs(), tree.GetEdgeCount());
     }
 }
 
@@ -55,16 +77,25 @@ void FatTreeResource::Allocate(const std::vector<const Node *> &hosts) {
 
 void FatTreeResource::Deallocate(const AggrTree &tree) {
     const auto &[nodes, edges] = tree;
-    for (auto node : nodes) {
-        if (node->Layer == 0)
-            continue;
-        assert(m_NodeUsage[node->ID] > 0);
-        --m_NodeUsage[node->ID];
-    }
-    for (auto edge : edges) {
-        assert(m_EdgeUsage[edge->ID] > 0);
-        --m_EdgeUsage[edge->ID];
-    }
+    if (NodeQuota)
+        for (auto node : nodes) {
+            if (node->Layer == 0)
+                continue;
+            assert(m_NodeUsage[node->ID] > 0);
+            --m_NodeUsage[node->ID];
+        }
+    if (LinkQuota)
+        for (auto edge : edges) {
+            assert(m_EdgeUsage[edge->ID] > 0);
+            --m_EdgeUsage[edge->ID];
+        }
+}
+
+void FatTreeResource::Deallocate(const CompactAggrTree &tree) {
+    if (NodeQuota)
+        IdSpanKernels::Decrement(m_NodeUsage.data(), tree.GetNodeIDs(), tree.GetNodeCount());
+    if (LinkQuota)
+        IdSpanKernels::Decrement(m_EdgeUsage.data(), tree.GetEdgeIDs(), tree.GetEdgeCount());
 }
 
 void FatTreeResource::Deallocate(const std::vector<const Node *> &hosts) {
@@ -91,6 +122,16 @@ bool FatTreeResource::CheckTreeConflict(const AggrTree &tree) const {
     return false;
 }
 
+bool FatTreeResource::CheckTreeConflict(const CompactAggrTree &tree) const {
+    if (NodeQuota &&
+        IdSpanKernels::AnyReachesQuota(m_NodeUsage.data(), tree.GetNodeIDs(), tree.GetNodeCount(), *NodeQuota))
+        return true;
+    if (LinkQuota &&
+        IdSpanKernels::AnyReachesQuota(m_EdgeUsage.data(), tree.GetEdgeIDs(), tree.GetEdgeCount(), *LinkQuota))
+        return true;
+    return false;
+}
+
 bool FatTreeResource::CheckTreeConflict(const AggrTree &tree1, const AggrTree &tree2) const {
     // TODO: Optimize
     const auto &[nodes1, edges1] = tree1;
@@ -108,6 +149,18 @@ bool FatTreeResource::CheckTreeConflict(const AggrTree &tree1, const AggrTree &t
     return false;
 }
 
+bool FatTreeResource::CheckTreeConflict(const CompactAggrTree &tree1, const CompactAggrTree &tree2) const {
+    if (NodeQuota && *NodeQuota < 2 && tree1.SharesNode(tree2))
+        return true;
+    if (LinkQuota && *LinkQuota < 2 && tree1.SharesEdge(tree2))
+        return true;
+    return false;
+}
+
+AggrTreeIndex FatTreeResource::CreateAggrTreeIndex() const {
+    return AggrTreeIndex(*Topology, NodeQuota && *NodeQuota < 2, LinkQuota && *LinkQuota < 2);
+}
+
 unsigned int FatTreeResource::CalcHostFragments(bool available) const {
     return CalcHostFragments(available, 0, Topology->NodesByLayer[0].size(), Topology->Height);
 }
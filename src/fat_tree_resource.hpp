@@ -1,5 +1,7 @@
 #pragma once
 
+#include "aggr_tree_index.hpp"
+#include "compact_aggr_tree.hpp"
 #include "fat_tree.hpp"
 #include <optional>
 #include <vector>
@@ -12,6 +14,8 @@ private:
 
     std::vector<unsigned int> m_NodeUsage;
     std::vector<unsigned int> m_EdgeUsage;
+    // The aggregation trees of the running jobs, keyed by job ID.
+    AggrTreeIndex m_AggrTreeIndex;
 
     unsigned int CalcHostFragments(bool available, unsigned int beginHostIdx, unsigned int hostCountInPod,
                                    unsigned int level) const;
@@ -23,15 +27,33 @@ public:
     explicit FatTreeResource(const FatTree &topology, std::optional<unsigned int> nodeQuota,
                              std::optional<unsigned int> linkQuota);
 
+    // The usage of switches and links is only counted for the types with a quota, since it is never checked otherwise.
+    // This also lets sharing groups allocate their trees concurrently, as they never share a quota-limited resource
+    // when the quotas are at most 1.
     const std::vector<unsigned int> &GetNodeUsage() const { return m_NodeUsage; }
     const std::vector<unsigned int> &GetEdgeUsage() const { return m_EdgeUsage; }
+    // Replaces the usage with one returned by GetNodeUsage and GetEdgeUsage on the same topology.
+    void SetUsage(std::vector<unsigned int> &&nodeUsage, std::vector<unsigned int> &&edgeUsage);
 
     void Allocate(const AggrTree &tree);
+    void Allocate(const CompactAggrTree &tree);
     void Allocate(const std::vector<const Node *> &hosts);
     void Deallocate(const AggrTree &tree);
+    void Deallocate(const CompactAggrTree &tree);
     void Deallocate(const std::vector<const Node *> &hosts);
     bool CheckTreeConflict(const AggrTree &tree) const;
+    bool CheckTreeConflict(const CompactAggrTree &tree) const;
     bool CheckTreeConflict(const AggrTree &tree1, const AggrTree &tree2) const;
+    bool CheckTreeConflict(const CompactAggrTree &tree1, const CompactAggrTree &tree2) const;
+
+    // Creates an empty index whose conflicts are the same as CheckTreeConflict(tree1, tree2).
+    AggrTreeIndex CreateAggrTreeIndex() const;
+    void RegisterTree(unsigned int jobId, const AggrTree &tree) { m_AggrTreeIndex.Register(jobId, tree); }
+    void UnregisterTree(unsigned int jobId) { m_AggrTreeIndex.Unregister(jobId); }
+    // Returns the sorted IDs of the jobs whose registered trees conflict with the tree.
+    std::vector<unsigned int> GetConflictingTrees(const AggrTree &tree) const {
+        return m_AggrTreeIndex.GetConflictingTrees(tree);
+    }
 
     unsigned int CalcHostFragments(bool available) const;
 };
@@ -2,7 +2,8 @@
 #include <cassert>
 
 std::optional<std::vector<const FatTree::Node *>>
-FirstHostAllocationPolicy::operator()(const FatTreeResource &resources, unsigned int hostCount) const {
+FirstHostAllocationPolicy::operator()(const FatTreeResource &resources, const Job &job, SimulationContext &) const {
+    auto hostCount = job.HostCount;
     assert(hostCount > 0);
     const auto &nodeUsage = resources.GetNodeUsage();
     const auto &hosts = resources.Topology->NodesByLayer[0];
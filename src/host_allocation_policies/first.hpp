@@ -2,6 +2,8 @@
 
 #include "fat_tree.hpp"
 #include "fat_tree_resource.hpp"
+#include "job.hpp"
+#include "simulation_context.hpp"
 #include <optional>
 #include <vector>
 
@@ -10,5 +12,6 @@ private:
     using Node = typename FatTree::Node;
 
 public:
-    std::optional<std::vector<const Node *>> operator()(const FatTreeResource &resources, unsigned int hostCount) const;
+    std::optional<std::vector<const Node *>> operator()(const FatTreeResource &resources, const Job &job,
+                                                        SimulationContext &context) const;
 };
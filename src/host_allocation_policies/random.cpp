@@ -4,7 +4,9 @@
 #include <random>
 
 std::optional<std::vector<const FatTree::Node *>>
-RandomHostAllocationPolicy::operator()(const FatTreeResource &resources, unsigned int hostCount) const {
+RandomHostAllocationPolicy::operator()(const FatTreeResource &resources, const Job &job,
+                                       SimulationContext &context) const {
+    auto hostCount = job.HostCount;
     assert(hostCount > 0);
     const auto &nodeUsage = resources.GetNodeUsage();
     const auto &hosts = resources.Topology->NodesByLayer[0];
@@ -15,7 +17,7 @@ RandomHostAllocationPolicy::operator()(const FatTreeResource &resources, unsigne
     if (availableHosts.size() < hostCount)
         return std::nullopt;
     std::vector<const Node *> chosenHosts;
-    thread_local std::default_random_engine engine(42);
+    auto engine = context.GetRandomEngine(RandomSubsystem::HostAllocation, job.ID);
     std::sample(availableHosts.cbegin(), availableHosts.cend(), std::back_inserter(chosenHosts), hostCount, engine);
     return chosenHosts;
 }
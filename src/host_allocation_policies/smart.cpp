@@ -61,7 +61,8 @@ unsigned int SmartHostAllocationPolicy::TryAllocate(const FatTreeResource &resou
 }
 
 std::optional<std::vector<const FatTree::Node *>>
-SmartHostAllocationPolicy::operator()(const FatTreeResource &resources, unsigned int hostCount) const {
+SmartHostAllocationPolicy::operator()(const FatTreeResource &resources, const Job &job, SimulationContext &) const {
+    auto hostCount = job.HostCount;
     assert(hostCount > 0);
     std::vector<TryAllocateResult> result(hostCount + 1);
     auto nAvailHosts = TryAllocate(resources, 0, resources.Topology->NodesByLayer[0].size(), FatTree::Height, result);
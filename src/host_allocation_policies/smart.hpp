@@ -2,6 +2,8 @@
 
 #include "fat_tree.hpp"
 #include "fat_tree_resource.hpp"
+#include "job.hpp"
+#include "simulation_context.hpp"
 #include <optional>
 #include <vector>
 
@@ -18,10 +20,10 @@ private:
                              unsigned int level, std::vector<TryAllocateResult> &result) const;
 
 public:
-    const double Alpha;
+    double Alpha;
 
     explicit SmartHostAllocationPolicy(double alpha) : Alpha(alpha) {}
 
-    std::optional<std::vector<const FatTree::Node *>> operator()(const FatTreeResource &resources,
-                                                                 unsigned int hostCount) const;
+    std::optional<std::vector<const FatTree::Node *>>
+    operator()(const FatTreeResource &resources, const Job &job, SimulationContext &context) const;
 };
@@ -1,30 +1,85 @@
 #include "job.hpp"
+#include "utils/binary_stream.hpp"
 #include "utils/trace.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
-double Job::CalcStepDuration(bool useSharp) const {
-    double stepDuration = 0.0;
-    for (const auto &opGroup : CommOpGroups) {
-        double groupDuration = 0.0;
-        for (const auto &op : opGroup.CommOps) {
-            auto opDuration = CalcTransmissionDuration(op.OpType, op.MessageSize, useSharp, HostCount);
-            groupDuration = std::max(groupDuration, op.StartTimeInGroup) + opDuration;
+bool JobPhase::IsSamePhase(const JobPhase &other, double tolerance) const {
+    auto isClose = [tolerance](double time1, double time2) { return std::abs(time1 - time2) <= tolerance; };
+    return GroupIdx == other.GroupIdx && OpIdx == other.OpIdx &&
+           OpTransmittedMessageSize == other.OpTransmittedMessageSize && IsRunning == other.IsRunning &&
+           IsUsingSharp == other.IsUsingSharp && IsWaiting == other.IsWaiting &&
+           TransmittingMessageSize == other.TransmittingMessageSize && isClose(GroupStartTime, other.GroupStartTime) &&
+           isClose(TransmissionStartTime, other.TransmissionStartTime) &&
+           isClose(TransmissionDuration, other.TransmissionDuration) &&
+           isClose(WaitingUntilTime, other.WaitingUntilTime);
+}
+
+JobModel::JobModel(std::shared_ptr<const std::vector<CommOpGroup>> commOpGroups, unsigned int hostCount,
+                   const DurationModel &calcTransmissionDuration)
+    : CommOpGroups(std::move(commOpGroups)), HostCount(hostCount), CalcTransmissionDuration(calcTransmissionDuration) {
+    for (bool useSharp : {false, true}) {
+        double stepDuration = 0.0;
+        for (const auto &opGroup : *CommOpGroups) {
+            double groupDuration = 0.0;
+            for (const auto &op : opGroup.CommOps) {
+                auto opDuration = calcTransmissionDuration(op.OpType, op.MessageSize, useSharp, HostCount);
+                groupDuration = std::max(groupDuration, op.StartTimeInGroup) + opDuration;
+                StepTransmissionDuration[useSharp] += opDuration;
+            }
+            groupDuration = std::max(groupDuration, opGroup.SyncTime);
+            stepDuration += groupDuration;
         }
-        groupDuration = std::max(groupDuration, opGroup.SyncTime);
-        stepDuration += groupDuration;
+        (useSharp ? StepDurationWithSharp : StepDurationWithoutSharp) = stepDuration;
+    }
+    // Relative to the group start, each CommOp maps its start time t to max(t, StartTimeInGroup) + Duration, so the
+    // CommOps after it compose into max(t + RestDuration, RestFinishTime), which is built backwards from the sync time.
+    for (const auto &opGroup : *CommOpGroups) {
+        auto &opTimings = CommOpTimings.emplace_back(opGroup.CommOps.size());
+        for (bool useSharp : {false, true}) {
+            double restDuration = 0.0, restFinishTime = opGroup.SyncTime;
+            for (auto opIdx = opGroup.CommOps.size(); opIdx-- > 0;) {
+                const auto &op = opGroup.CommOps[opIdx];
+                auto &opTiming = opTimings[opIdx];
+                opTiming.Duration[useSharp] = calcTransmissionDuration(op.OpType, op.MessageSize, useSharp, HostCount);
+                opTiming.RestDuration[useSharp] = restDuration;
+                opTiming.RestFinishTime[useSharp] = restFinishTime;
+                restDuration += opTiming.Duration[useSharp];
+                restFinishTime = std::max(restFinishTime, op.StartTimeInGroup + restDuration);
+            }
+        }
+    }
+    // A group ends no earlier than its sync time, nor than the start time of any of its CommOps
+    for (const auto &opGroup : *CommOpGroups) {
+        auto minGroupDuration = opGroup.SyncTime;
+        for (const auto &op : opGroup.CommOps)
+            minGroupDuration = std::max(minGroupDuration, op.StartTimeInGroup);
+        MinGroupDurations.push_back(minGroupDuration);
+        MinStepDuration += minGroupDuration;
     }
-    return stepDuration;
 }
 
-Job::Job(unsigned int hostCount, std::optional<unsigned int> stepCount, std::vector<CommOpGroup> &&commOpGroups)
-    : ID(m_NextID++), HostCount(hostCount), StepCount(stepCount), CommOpGroups(std::move(commOpGroups)) {
-    StepDurationWithSharp = CalcStepDuration(true);
-    StepDurationWithoutSharp = CalcStepDuration(false);
-}
+Job::Job(unsigned int hostCount, std::optional<unsigned int> stepCount, std::vector<CommOpGroup> &&commOpGroups,
+         const JobModel::DurationModel &calcTransmissionDuration)
+    : Job(stepCount,
+          std::make_shared<JobModel>(std::make_shared<const std::vector<CommOpGroup>>(std::move(commOpGroups)),
+                                     hostCount, calcTransmissionDuration)) {}
+
+Job::Job(std::optional<unsigned int> stepCount, std::shared_ptr<const JobModel> model)
+    : m_Model(std::move(model)), HostCount(m_Model->HostCount), StepCount(stepCount),
+      CommOpGroups(*m_Model->CommOpGroups), StepDurationWithSharp(m_Model->StepDurationWithSharp),
+      StepDurationWithoutSharp(m_Model->StepDurationWithoutSharp) {}
 
 double Job::GetNextEvent(double now) const {
     if (!m_IsStarted)
         return now;
+    if (m_IsFastForwarding) {
+        auto stepDuration = m_FastForwardUseSharp ? StepDurationWithSharp : StepDurationWithoutSharp;
+        return m_FastForwardStartTime + (*StepCount - m_FastForwardStepIdx) * stepDuration;
+    }
     assert(!m_IsFinished);
     assert(!StepCount || m_CurrentStepIdx < *StepCount);
     assert(m_CurrentGroupIdx < CommOpGroups.size());
@@ -40,87 +95,142 @@ double Job::GetNextEvent(double now) const {
 }
 
 bool Job::RunNextEvent(double now) {
-    if (!m_IsStarted) {
-        Trace.RecordBeginJob(now, *this);
-        Trace.RecordBeginStep(now, *this);
-        Trace.RecordBeginGroup(now, *this);
-        m_IsStarted = true;
-        m_StartTime = now;
-        m_CurrentGroupStartTime = now;
-        return false;
+    struct CallbackHooks {
+        Job &ThisJob;
+
+        CommOpScheduleResult BeforeTransmission(const Job &job, double now) {
+            return ThisJob.m_BeforeTransmissionCallback(job, now);
+        }
+        void AfterTransmission(const Job &job, double now) { ThisJob.m_AfterTransmissionCallback(job, now); }
+    } hooks{*this};
+    return RunNextEvent(now, hooks);
+}
+
+bool Job::IsAtStepBeginning(double now) const {
+    return m_IsStarted && !m_IsFinished && !m_IsFastForwarding && m_CurrentGroupIdx == 0 && m_CurrentOpIdx == 0 &&
+           m_CurrentOpTransmittedMessageSize == 0 && !m_IsRunning && m_CurrentGroupStartTime == now &&
+           m_WaitingUntilTime < now;
+}
+
+void Job::StartFastForward(double now, bool useSharp) {
+    assert(StepCount);
+    assert(IsAtStepBeginning(now));
+    assert(!useSharp || m_AggrTree);
+    assert(!m_NextAggrTree);
+    m_IsFastForwarding = true;
+    m_FastForwardUseSharp = useSharp;
+    m_FastForwardStepIdx = m_CurrentStepIdx;
+    m_FastForwardStartTime = now;
+}
+
+void Job::StopFastForward(double now, bool runEventsAtNow) {
+    assert(m_IsFastForwarding);
+    assert(now >= m_FastForwardStartTime && now <= GetNextEvent(now));
+    m_IsFastForwarding = false;
+    auto isPending = [now, runEventsAtNow](double time) { return runEventsAtNow ? time > now : time >= now; };
+    auto useSharp = m_FastForwardUseSharp;
+    auto &duration = useSharp ? m_DurationWithSharp : m_DurationWithoutSharp;
+    auto stepDuration = useSharp ? StepDurationWithSharp : StepDurationWithoutSharp;
+    auto remainingStepCount = *StepCount - m_FastForwardStepIdx;
+    // Jump to the last step that has begun, at the extrapolated time that GetNextEvent also uses
+    unsigned int skippedStepCount = 0;
+    if (now > m_FastForwardStartTime && stepDuration > 0.0) {
+        skippedStepCount = std::ceil((now - m_FastForwardStartTime) / stepDuration) - 1.0;
+        skippedStepCount = std::min(skippedStepCount, remainingStepCount - 1);
+        while (skippedStepCount > 0 && isPending(m_FastForwardStartTime + skippedStepCount * stepDuration))
+            --skippedStepCount;
     }
-    assert(!m_IsFinished);
-    assert(!StepCount || m_CurrentStepIdx < *StepCount);
-    assert(m_CurrentGroupIdx < CommOpGroups.size());
-    const auto &opGroup = CommOpGroups[m_CurrentGroupIdx];
-    if (m_CurrentOpIdx >= opGroup.CommOps.size()) {
-        assert(!m_IsRunning);
-        assert(now >= m_CurrentGroupStartTime + opGroup.SyncTime);
-        Trace.RecordEndGroup(now, *this);
-        m_CurrentOpIdx = 0;
-        ++m_CurrentGroupIdx;
-        if (m_CurrentGroupIdx >= CommOpGroups.size()) {
-            Trace.RecordEndStep(now, *this);
-            m_CurrentGroupIdx = 0;
-            ++m_CurrentStepIdx;
-            if (StepCount && m_CurrentStepIdx >= *StepCount) {
-                Trace.RecordEndJob(now, *this);
-                m_IsFinished = true;
-                m_FinishTime = now;
-                return true;
+    m_CurrentStepIdx = m_FastForwardStepIdx + skippedStepCount;
+    duration += skippedStepCount * m_Model->StepTransmissionDuration[useSharp];
+    // Replay the rest event by event, which may cross a step boundary due to rounding errors
+    auto groupStartTime = m_FastForwardStartTime + skippedStepCount * stepDuration;
+    while (true) {
+        for (m_CurrentGroupIdx = 0; m_CurrentGroupIdx < CommOpGroups.size(); ++m_CurrentGroupIdx) {
+            const auto &opGroup = CommOpGroups[m_CurrentGroupIdx];
+            m_CurrentGroupStartTime = groupStartTime;
+            auto opFinishTime = groupStartTime;
+            for (m_CurrentOpIdx = 0; m_CurrentOpIdx < opGroup.CommOps.size(); ++m_CurrentOpIdx) {
+                const auto &op = opGroup.CommOps[m_CurrentOpIdx];
+                auto opStartTime = std::max(opFinishTime, groupStartTime + op.StartTimeInGroup);
+                if (isPending(opStartTime))
+                    return;
+                auto opDuration = m_Model->CommOpTimings[m_CurrentGroupIdx][m_CurrentOpIdx].Duration[useSharp];
+                opFinishTime = opStartTime + opDuration;
+                if (isPending(opFinishTime)) {
+                    m_IsRunning = true;
+                    m_IsUsingSharp = useSharp;
+                    m_TransmittingMessageSize = op.MessageSize;
+                    m_CurrentTransmissionDuration = opDuration;
+                    m_CurrentTransmissionStartTime = opStartTime;
+                    return;
+                }
+                duration += opDuration;
             }
-            Trace.RecordBeginStep(now, *this);
+            groupStartTime = std::max(opFinishTime, groupStartTime + opGroup.SyncTime);
+            bool isLastGroup = m_CurrentStepIdx + 1 == *StepCount && m_CurrentGroupIdx + 1 == CommOpGroups.size();
+            if (isPending(groupStartTime) || isLastGroup)
+                return;
         }
-        Trace.RecordBeginGroup(now, *this);
-        m_CurrentGroupStartTime = now;
-        return false;
+        ++m_CurrentStepIdx;
     }
-    const auto &op = opGroup.CommOps[m_CurrentOpIdx];
+}
+
+double Job::CalcFinishTimeLowerBound(double now) const {
+    if (!StepCount)
+        return std::numeric_limits<double>::infinity();
+    if (!m_IsStarted)
+        return now + *StepCount * m_Model->MinStepDuration;
+    if (m_IsFastForwarding)
+        return GetNextEvent(now);
+    assert(!m_IsFinished);
+    auto finishTime = m_CurrentGroupStartTime + m_Model->MinGroupDurations[m_CurrentGroupIdx];
+    if (m_IsRunning)
+        finishTime = std::max(finishTime, m_CurrentTransmissionStartTime + m_CurrentTransmissionDuration);
+    for (auto groupIdx = m_CurrentGroupIdx + 1; groupIdx < CommOpGroups.size(); ++groupIdx)
+        finishTime += m_Model->MinGroupDurations[groupIdx];
+    return finishTime + (*StepCount - m_CurrentStepIdx - 1) * m_Model->MinStepDuration;
+}
+
+JobPhase Job::GetPhase(double now) const {
+    assert(m_IsStarted && !m_IsFinished && !m_IsFastForwarding);
+    JobPhase phase{};
+    phase.StepIdx = m_CurrentStepIdx;
+    phase.GroupIdx = m_CurrentGroupIdx;
+    phase.OpIdx = m_CurrentOpIdx;
+    phase.OpTransmittedMessageSize = m_CurrentOpTransmittedMessageSize;
+    phase.IsRunning = m_IsRunning;
+    phase.GroupStartTime = m_CurrentGroupStartTime - now;
     if (m_IsRunning) {
-        assert(now == m_CurrentTransmissionStartTime + m_CurrentTransmissionDuration);
-        Trace.RecordEndTransmission(now, *this);
-        m_IsRunning = false;
-        m_CurrentOpTransmittedMessageSize += m_TransmittingMessageSize;
-        assert(m_CurrentOpTransmittedMessageSize <= op.MessageSize);
-        if (m_CurrentOpTransmittedMessageSize == op.MessageSize) {
-            Trace.RecordEndCommOp(now, *this);
-            m_CurrentOpTransmittedMessageSize = 0;
-            ++m_CurrentOpIdx;
-        }
-        (m_IsUsingSharp ? m_DurationWithSharp : m_DurationWithoutSharp) += m_CurrentTransmissionDuration;
-        m_AfterTransmissionCallback(*this, now);
-        if (m_NextAggrTree) {
-            if (m_NextAggrTree != m_AggrTree)
-                ++m_TreeMigrationCount;
-            m_AggrTree = std::move(*m_NextAggrTree);
-            m_NextAggrTree = std::nullopt;
-        }
-        return false;
-    }
-    if (m_CurrentOpTransmittedMessageSize == 0 && now != m_WaitingUntilTime)
-        Trace.RecordBeginCommOp(now, *this);
-    auto scheduleRes = m_BeforeTransmissionCallback(*this, now);
-    if (scheduleRes.InsertWaitingTime) {
-        Trace.RecordBeginWaiting(now, *this);
-        m_WaitingUntilTime = now + scheduleRes.WaitingTime;
-        return false;
-    }
-    if (now == m_WaitingUntilTime) {
-        Trace.RecordEndWaiting(now, *this);
-        m_WaitingUntilTime = 0.0;
-    }
-    assert(!scheduleRes.UseSharp || m_AggrTree);
-    m_IsRunning = true;
-    m_IsUsingSharp = scheduleRes.UseSharp;
-    m_TransmittingMessageSize = scheduleRes.MessageSize;
-    if (m_TransmittingMessageSize == -1ull)
-        m_TransmittingMessageSize = op.MessageSize - m_CurrentOpTransmittedMessageSize;
-    assert(m_CurrentOpTransmittedMessageSize + m_TransmittingMessageSize <= op.MessageSize);
-    m_CurrentTransmissionDuration =
-        CalcTransmissionDuration(op.OpType, m_TransmittingMessageSize, m_IsUsingSharp, HostCount);
-    m_CurrentTransmissionStartTime = now;
-    Trace.RecordBeginTransmission(now, *this);
-    return false;
+        phase.IsUsingSharp = m_IsUsingSharp;
+        phase.TransmittingMessageSize = m_TransmittingMessageSize;
+        phase.TransmissionStartTime = m_CurrentTransmissionStartTime - now;
+        phase.TransmissionDuration = m_CurrentTransmissionDuration;
+    }
+    // The waiting time is left over once it has passed
+    phase.IsWaiting = m_WaitingUntilTime >= now;
+    if (phase.IsWaiting)
+        phase.WaitingUntilTime = m_WaitingUntilTime - now;
+    phase.DurationWithSharp = m_DurationWithSharp;
+    phase.DurationWithoutSharp = m_DurationWithoutSharp;
+    phase.ConsensusCount = m_ConsensusCount;
+    return phase;
+}
+
+void Job::SkipPeriods(const JobPhase &begin, const JobPhase &end, double period, unsigned int periodCount) {
+    assert(!m_IsFastForwarding);
+    assert(m_CurrentStepIdx == end.StepIdx && m_IsRunning == end.IsRunning);
+    assert(end.StepIdx >= begin.StepIdx);
+    m_CurrentStepIdx += periodCount * (end.StepIdx - begin.StepIdx);
+    assert(!StepCount || m_CurrentStepIdx < *StepCount);
+    m_DurationWithSharp += periodCount * (end.DurationWithSharp - begin.DurationWithSharp);
+    m_DurationWithoutSharp += periodCount * (end.DurationWithoutSharp - begin.DurationWithoutSharp);
+    m_ConsensusCount += periodCount * (end.ConsensusCount - begin.ConsensusCount);
+    auto shift = periodCount * period;
+    m_CurrentGroupStartTime += shift;
+    if (m_IsRunning)
+        m_CurrentTransmissionStartTime += shift;
+    if (end.IsWaiting)
+        m_WaitingUntilTime += shift;
 }
 
 std::optional<CommOpRunningInfo> Job::GetNextCommOpInfo(double now) const {
@@ -156,24 +266,27 @@ std::optional<CommOpRunningInfo> Job::GetNextCommOpInfo(double now) const {
     }
     const auto &op = CommOpGroups[groupIdx].CommOps[opIdx];
     auto startTime = std::max(now, std::max(m_WaitingUntilTime, groupStartTime + op.StartTimeInGroup));
-    auto durationWithSharp =
-        CalcTransmissionDuration(op.OpType, op.MessageSize - opTransmittedMessageSize, true, HostCount);
-    auto durationWithoutSharp =
-        CalcTransmissionDuration(op.OpType, op.MessageSize - opTransmittedMessageSize, false, HostCount);
+    double durationWithSharp, durationWithoutSharp;
+    if (opTransmittedMessageSize == 0) {
+        const auto &opTiming = m_Model->CommOpTimings[groupIdx][opIdx];
+        durationWithSharp = opTiming.Duration[true];
+        durationWithoutSharp = opTiming.Duration[false];
+    } else {
+        durationWithSharp =
+            m_Model->CalcTransmissionDuration(op.OpType, op.MessageSize - opTransmittedMessageSize, true, HostCount);
+        durationWithoutSharp =
+            m_Model->CalcTransmissionDuration(op.OpType, op.MessageSize - opTransmittedMessageSize, false, HostCount);
+    }
     return CommOpRunningInfo{groupStartTime, startTime, durationWithSharp, durationWithoutSharp, groupIdx, opIdx};
 }
 
 double Job::GetNextCommOpPriority(const CommOpRunningInfo &commOpInfo) const {
-    auto calcGroupFinishTime = [this, &commOpInfo](bool useSharpOnNext, bool useSharpOnRest) -> double {
-        const auto &opGroup = CommOpGroups[commOpInfo.GroupIdx];
+    const auto &opTiming = m_Model->CommOpTimings[commOpInfo.GroupIdx][commOpInfo.OpIdx];
+    auto calcGroupFinishTime = [&commOpInfo, &opTiming](bool useSharpOnNext, bool useSharpOnRest) -> double {
         auto now =
             commOpInfo.OpStartTime + (useSharpOnNext ? commOpInfo.DurationWithSharp : commOpInfo.DurationWithoutSharp);
-        for (unsigned int opIdx = commOpInfo.OpIdx + 1; opIdx < opGroup.CommOps.size(); ++opIdx) {
-            const auto &op = opGroup.CommOps[opIdx];
-            auto duration = CalcTransmissionDuration(op.OpType, op.MessageSize, useSharpOnRest, HostCount);
-            now = std::max(now, commOpInfo.GroupStartTime + op.StartTimeInGroup) + duration;
-        }
-        return std::max(now, commOpInfo.GroupStartTime + opGroup.SyncTime);
+        return std::max(now + opTiming.RestDuration[useSharpOnRest],
+                        commOpInfo.GroupStartTime + opTiming.RestFinishTime[useSharpOnRest]);
     };
     // TODO: should useSharpOnRest be true of false?
     return calcGroupFinishTime(false, false) - calcGroupFinishTime(true, false);
@@ -186,8 +299,127 @@ void Job::SetHosts(std::vector<const FatTree::Node *> &&hosts) {
 }
 
 void Job::SetNextAggrTree(std::optional<FatTree::AggrTree> &&aggrTree) {
-    if (m_IsRunning && m_IsUsingSharp)
+    std::optional<CompactAggrTree> compactAggrTree;
+    if (aggrTree)
+        compactAggrTree.emplace(*aggrTree);
+    if (compactAggrTree != GetNextCompactAggrTree())
+        ++m_AggrTreeVersion;
+    if (m_IsRunning && m_IsUsingSharp) {
         m_NextAggrTree = std::move(aggrTree);
-    else
+        m_NextCompactAggrTree = std::move(compactAggrTree);
+    } else {
         m_AggrTree = std::move(aggrTree);
+        m_CompactAggrTree = std::move(compactAggrTree);
+    }
+}
+
+static void WriteAggrTree(BinaryWriter &writer, const std::optional<FatTree::AggrTree> &aggrTree) {
+    writer.Write(aggrTree.has_value());
+    if (!aggrTree)
+        return;
+    std::vector<unsigned int> nodeIDs, edgeIDs;
+    for (auto node : aggrTree->first)
+        nodeIDs.push_back(node->ID);
+    for (auto edge : aggrTree->second)
+        edgeIDs.push_back(edge->ID);
+    writer.WriteVector(nodeIDs);
+    writer.WriteVector(edgeIDs);
+}
+
+static std::optional<FatTree::AggrTree> ReadAggrTree(BinaryReader &reader, const FatTree &topology) {
+    if (!reader.Read<bool>())
+        return std::nullopt;
+    FatTree::AggrTree aggrTree;
+    for (auto nodeID : reader.ReadVector<unsigned int>()) {
+        if (nodeID >= topology.Nodes.size())
+            throw std::runtime_error("Aggregation tree out of the topology");
+        aggrTree.first.push_back(&topology.Nodes[nodeID]);
+    }
+    for (auto edgeID : reader.ReadVector<unsigned int>()) {
+        if (edgeID >= topology.Edges.size())
+            throw std::runtime_error("Aggregation tree out of the topology");
+        aggrTree.second.push_back(&topology.Edges[edgeID]);
+    }
+    return aggrTree;
+}
+
+void Job::SaveState(BinaryWriter &writer) const {
+    assert(!m_IsFastForwarding);
+    writer.Write(m_CurrentStepIdx);
+    writer.Write(m_CurrentGroupIdx);
+    writer.Write(m_CurrentOpIdx);
+    writer.Write(m_CurrentOpTransmittedMessageSize);
+    writer.Write(m_IsRunning);
+    writer.Write(m_WaitingUntilTime);
+    writer.Write(m_TransmittingMessageSize);
+    writer.Write(m_CurrentTransmissionDuration);
+    writer.Write(m_CurrentGroupStartTime);
+    writer.Write(m_CurrentTransmissionStartTime);
+    writer.Write(m_IsUsingSharp);
+    writer.Write(m_IsStarted);
+    writer.Write(m_IsFinished);
+    writer.Write(m_SubmitTime);
+    writer.Write(m_StartTime);
+    writer.Write(m_FinishTime);
+    writer.Write(m_DurationWithSharp);
+    writer.Write(m_DurationWithoutSharp);
+    writer.Write(m_TreeMigrationCount);
+    writer.Write(m_ConsensusCount);
+    std::vector<unsigned int> hostIDs;
+    for (auto host : m_Hosts)
+        hostIDs.push_back(host->ID);
+    writer.WriteVector(hostIDs);
+    WriteAggrTree(writer, m_AggrTree);
+    writer.Write(m_NextAggrTree.has_value());
+    if (m_NextAggrTree)
+        WriteAggrTree(writer, *m_NextAggrTree);
+    writer.Write(m_AggrTreeVersion);
+}
+
+void Job::LoadState(BinaryReader &reader, const FatTree &topology) {
+    assert(!m_IsStarted && m_Hosts.empty());
+    m_CurrentStepIdx = reader.Read<unsigned int>();
+    m_CurrentGroupIdx = reader.Read<unsigned int>();
+    m_CurrentOpIdx = reader.Read<unsigned int>();
+    m_CurrentOpTransmittedMessageSize = reader.Read<unsigned long long>();
+    m_IsRunning = reader.Read<bool>();
+    m_WaitingUntilTime = reader.Read<double>();
+    m_TransmittingMessageSize = reader.Read<unsigned long long>();
+    m_CurrentTransmissionDuration = reader.Read<double>();
+    m_CurrentGroupStartTime = reader.Read<double>();
+    m_CurrentTransmissionStartTime = reader.Read<double>();
+    m_IsUsingSharp = reader.Read<bool>();
+    m_IsStarted = reader.Read<bool>();
+    m_IsFinished = reader.Read<bool>();
+    m_SubmitTime = reader.Read<double>();
+    m_StartTime = reader.Read<double>();
+    m_FinishTime = reader.Read<double>();
+    m_DurationWithSharp = reader.Read<double>();
+    m_DurationWithoutSharp = reader.Read<double>();
+    m_TreeMigrationCount = reader.Read<unsigned int>();
+    m_ConsensusCount = reader.Read<unsigned int>();
+    if ((StepCount && m_CurrentStepIdx >= *StepCount) || m_CurrentGroupIdx >= CommOpGroups.size() ||
+        m_CurrentOpIdx > CommOpGroups[m_CurrentGroupIdx].CommOps.size())
+        throw std::runtime_error("Job state out of the model");
+    auto hostIDs = reader.ReadVector<unsigned int>();
+    if (hostIDs.size() != HostCount)
+        throw std::runtime_error("Job state with a wrong number of hosts");
+    for (auto hostID : hostIDs) {
+        if (hostID >= topology.NodesByLayer[0].size())
+            throw std::runtime_error("Host out of the topology");
+        m_Hosts.push_back(&topology.Nodes[hostID]);
+    }
+    m_AggrTree = ReadAggrTree(reader, topology);
+    m_CompactAggrTree = std::nullopt;
+    if (m_AggrTree)
+        m_CompactAggrTree.emplace(*m_AggrTree);
+    m_NextAggrTree = std::nullopt;
+    m_NextCompactAggrTree = std::nullopt;
+    if (reader.Read<bool>()) {
+        m_NextAggrTree = ReadAggrTree(reader, topology);
+        m_NextCompactAggrTree.emplace();
+        if (*m_NextAggrTree)
+            m_NextCompactAggrTree->emplace(**m_NextAggrTree);
+    }
+    m_AggrTreeVersion = reader.Read<unsigned int>();
 }
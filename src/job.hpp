@@ -1,11 +1,17 @@
 #pragma once
 
+#include "compact_aggr_tree.hpp"
 #include "fat_tree.hpp"
-#include <atomic>
+#include "utils/trace.hpp"
+#include <cassert>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <vector>
 
+class BinaryReader;
+class BinaryWriter;
+
 struct CommOp {
     enum class Type {
         AllReduce,
@@ -44,10 +50,65 @@ struct CommOpRunningInfo {
     unsigned int OpIdx;
 };
 
+// The state of a job relative to a point in time. In a periodic schedule, the relative part is the same at the same
+// point of every period, while the step index and the accumulated counters grow by the same amount.
+struct JobPhase {
+    unsigned int StepIdx;
+    unsigned int GroupIdx;
+    unsigned int OpIdx;
+    unsigned long long OpTransmittedMessageSize;
+    bool IsRunning;
+    bool IsUsingSharp;
+    bool IsWaiting;
+    unsigned long long TransmittingMessageSize;
+    double GroupStartTime;        // Relative
+    double TransmissionStartTime; // Relative
+    double TransmissionDuration;
+    double WaitingUntilTime; // Relative
+    double DurationWithSharp;
+    double DurationWithoutSharp;
+    unsigned int ConsensusCount;
+
+    // Returns whether the relative parts are the same, with times compared within the tolerance in second.
+    bool IsSamePhase(const JobPhase &other, double tolerance) const;
+};
+
+// The CommOpGroups of a model and their timing for a number of hosts, which can be shared by all the jobs of the model
+// with that number of hosts. The timing follows the given duration model.
+class JobModel {
+public:
+    // The timing of a CommOp, indexed by whether to use SHARP. Running the CommOps after it from time t, all with the
+    // same SHARP decision and without waiting, ends the group at max(t + RestDuration, group start time +
+    // RestFinishTime).
+    struct CommOpTiming {
+        double Duration[2];
+        double RestDuration[2];
+        double RestFinishTime[2]; // Relative to the group start time
+    };
+
+    // Given CommOp type, message size, whether to use SHARP, and # of hosts, returns the duration of CommOp in seconds.
+    using DurationModel = std::function<double(CommOp::Type, unsigned long long, bool, unsigned int)>;
+
+    const std::shared_ptr<const std::vector<CommOpGroup>> CommOpGroups;
+    const unsigned int HostCount;
+    // The duration model the timing follows, also used for the transmissions of part of a CommOp.
+    const DurationModel CalcTransmissionDuration;
+
+    std::vector<std::vector<CommOpTiming>> CommOpTimings;
+    double StepDurationWithSharp;
+    double StepDurationWithoutSharp;
+    // The sum of the transmission durations of all CommOps in a step, indexed by whether to use SHARP.
+    double StepTransmissionDuration[2] = {0.0, 0.0};
+    // The least duration of each CommOpGroup and of a step whatever the transmission durations are.
+    std::vector<double> MinGroupDurations;
+    double MinStepDuration = 0.0;
+
+    explicit JobModel(std::shared_ptr<const std::vector<CommOpGroup>> commOpGroups, unsigned int hostCount,
+                      const DurationModel &calcTransmissionDuration);
+};
+
 class Job {
 private:
-    inline static std::atomic<unsigned int> m_NextID = 0;
-
     // Given the job and the current time, returns CommOpScheduleResult.
     std::function<CommOpScheduleResult(const Job &, double)> m_BeforeTransmissionCallback;
     // Given the job and the current time, returns nothing.
@@ -59,17 +120,18 @@ private:
     unsigned long long m_CurrentOpTransmittedMessageSize = 0;
     bool m_IsRunning = false;
     double m_WaitingUntilTime = -1.0;
-    unsigned long long m_TransmittingMessageSize;
-    double m_CurrentTransmissionDuration;
+    unsigned long long m_TransmittingMessageSize = 0;
+    double m_CurrentTransmissionDuration = 0.0;
 
-    double m_CurrentGroupStartTime;
-    double m_CurrentTransmissionStartTime;
-    bool m_IsUsingSharp;
+    double m_CurrentGroupStartTime = 0.0;
+    double m_CurrentTransmissionStartTime = 0.0;
+    bool m_IsUsingSharp = false;
 
     bool m_IsStarted = false;
     bool m_IsFinished = false;
-    double m_StartTime;
-    double m_FinishTime;
+    double m_SubmitTime = 0.0;
+    double m_StartTime = 0.0;
+    double m_FinishTime = 0.0;
     double m_DurationWithSharp = 0.0;
     double m_DurationWithoutSharp = 0.0;
     unsigned int m_TreeMigrationCount = 0;
@@ -78,28 +140,73 @@ private:
     std::vector<const FatTree::Node *> m_Hosts;
     std::optional<FatTree::AggrTree> m_AggrTree;
     std::optional<std::optional<FatTree::AggrTree>> m_NextAggrTree;
+    // The same trees in compact form, used on the hot paths.
+    std::optional<CompactAggrTree> m_CompactAggrTree;
+    std::optional<std::optional<CompactAggrTree>> m_NextCompactAggrTree;
+    unsigned int m_AggrTreeVersion = 0; // Incremented whenever the next aggregation tree is changed
 
-    double CalcStepDuration(bool useSharp) const;
+    std::shared_ptr<const JobModel> m_Model;
+    Tracer *m_Tracer = nullptr;
 
-public:
-    // Given CommOp type, message size, whether to use SHARP, and # of hosts, returns the duration of CommOp in seconds.
-    inline static std::function<double(CommOp::Type, unsigned long long, bool, unsigned int)> CalcTransmissionDuration;
+    void RecordTrace(TraceEvent::Kind kind, bool isBegin, double now) const {
+        if constexpr (Tracer::IsEnabled)
+            if (m_Tracer && m_Tracer->IsEventTraced(kind, now))
+                m_Tracer->Record(kind, isBegin, now, *this);
+    }
+
+    bool m_IsFastForwarding = false;
+    bool m_FastForwardUseSharp;
+    unsigned int m_FastForwardStepIdx; // The step where fast-forwarding started
+    double m_FastForwardStartTime;     // The start time of that step
 
-    const unsigned int ID;
+public:
+    // Given by the simulation when the job is taken from its source or submitted, numbered from 0 in that order, and
+    // kept by copies.
+    unsigned int ID = 0;
     const unsigned int HostCount;
     const std::optional<unsigned int> StepCount;
-    const std::vector<CommOpGroup> CommOpGroups;
+    const std::vector<CommOpGroup> &CommOpGroups;
 
-    double StepDurationWithSharp;
-    double StepDurationWithoutSharp;
+    const double StepDurationWithSharp;
+    const double StepDurationWithoutSharp;
 
-    explicit Job(unsigned int hostCount, std::optional<unsigned int> stepCount,
-                 std::vector<CommOpGroup> &&commOpGroups);
+    explicit Job(unsigned int hostCount, std::optional<unsigned int> stepCount, std::vector<CommOpGroup> &&commOpGroups,
+                 const JobModel::DurationModel &calcTransmissionDuration);
+    // Shares the model with the other jobs of it, so that nothing but the job is allocated.
+    explicit Job(std::optional<unsigned int> stepCount, std::shared_ptr<const JobModel> model);
+    // A copy is the same job with the same ID and the same model, e.g. in a fork of the simulation.
+    Job(const Job &) = default;
 
     // Returns the time of the next event.
     double GetNextEvent(double now) const;
     // Returns whether the job is finished.
     bool RunNextEvent(double now);
+    // The same as above with the callbacks replaced by the hooks, which are called directly so that they can be
+    // inlined. THooks provides BeforeTransmission and AfterTransmission with the same signatures as the callbacks.
+    template <typename THooks>
+    bool RunNextEvent(double now, THooks &hooks);
+
+    // Returns whether the job has just begun a step at the current time and none of its CommOps has run yet.
+    bool IsAtStepBeginning(double now) const;
+    // Skips all the events of the remaining steps, assuming that every CommOp is transmitted as a whole with the given
+    // SHARP decision and without waiting, so the next event is the end of the job. The job must be at the beginning of
+    // a step and have a finite number of steps. Callbacks and traces are skipped as well. The times of the skipped
+    // steps are extrapolated as multiples of the step duration rather than summed op by op as the events would, so
+    // they differ from the event-by-event times by rounding errors that grow with the number of steps skipped.
+    void StartFastForward(double now, bool useSharp);
+    // Leaves the job in the state it would be in if its events before the current time had been run one by one, and
+    // also those at the current time if runEventsAtNow, up to the rounding errors of the extrapolated step times.
+    void StopFastForward(double now, bool runEventsAtNow);
+    bool IsFastForwarding() const { return m_IsFastForwarding; }
+
+    // Returns a lower bound of the finish time that holds whatever the transmission durations and the SHARP decisions
+    // are, infinity if the job never finishes.
+    double CalcFinishTimeLowerBound(double now) const;
+
+    JobPhase GetPhase(double now) const;
+    // Advances the job by whole periods of a periodic schedule, in each of which it goes from the begin phase to the
+    // end phase. The job must be in the end phase.
+    void SkipPeriods(const JobPhase &begin, const JobPhase &end, double period, unsigned int periodCount);
 
     std::optional<CommOpRunningInfo> GetNextCommOpInfo(double now) const;
     double GetNextCommOpPriority(const CommOpRunningInfo &commOpInfo) const;
@@ -114,6 +221,7 @@ public:
     bool IsUsingSharp() const { return m_IsUsingSharp; }
     bool IsStarted() const { return m_IsStarted; }
     bool IsFinished() const { return m_IsFinished; }
+    double GetSubmitTime() const { return m_SubmitTime; }
     double GetStartTime() const { return m_StartTime; }
     double GetFinishTime() const { return m_FinishTime; }
     double GetDurationWithSharp() const { return m_DurationWithSharp; }
@@ -125,6 +233,13 @@ public:
     const std::optional<FatTree::AggrTree> &GetNextAggrTree() const {
         return m_NextAggrTree ? *m_NextAggrTree : m_AggrTree;
     }
+    const std::optional<CompactAggrTree> &GetCurrentCompactAggrTree() const { return m_CompactAggrTree; }
+    const std::optional<CompactAggrTree> &GetNextCompactAggrTree() const {
+        return m_NextCompactAggrTree ? *m_NextCompactAggrTree : m_CompactAggrTree;
+    }
+    unsigned int GetAggrTreeVersion() const { return m_AggrTreeVersion; }
+    // Returns whether the aggregation tree is changed while in use, so the old one is kept until the transmission ends.
+    bool IsMigratingAggrTree() const { return m_NextAggrTree.has_value(); }
 
     void SetBeforeTransmissionCallback(const decltype(m_BeforeTransmissionCallback) &callback) {
         m_BeforeTransmissionCallback = callback;
@@ -132,7 +247,124 @@ public:
     void SetAfterTransmissionCallback(const decltype(m_AfterTransmissionCallback) &callback) {
         m_AfterTransmissionCallback = callback;
     }
+    // Sets the time the job is submitted, before which it is not allocated. Jobs are submitted at 0 by default, so that
+    // each is allocated as soon as there are enough hosts.
+    void SetSubmitTime(double submitTime) { m_SubmitTime = submitTime; }
+    // Records the events of the job from now on, or stops recording if nullptr.
+    void SetTracer(Tracer *tracer) { m_Tracer = tracer; }
+    bool IsTraced() const { return Tracer::IsEnabled && m_Tracer; }
     void SetHosts(std::vector<const FatTree::Node *> &&hosts);
     void SetNextAggrTree(std::optional<FatTree::AggrTree> &&aggrTree);
     void IncrementConsensusCount() { ++m_ConsensusCount; }
+
+    // Writes the progress of the job, including the transmission in flight and the hosts and trees it holds, which
+    // must not be fast-forwarding. Neither the ID nor the model is written.
+    void SaveState(BinaryWriter &writer) const;
+    // Reads what SaveState writes into a job of the same model that has not started, with the hosts and trees taken
+    // from the topology. Throws std::runtime_error on a truncated state or one that does not fit the topology.
+    void LoadState(BinaryReader &reader, const FatTree &topology);
 };
+
+template <typename THooks>
+bool Job::RunNextEvent(double now, THooks &hooks) {
+    if (!m_IsStarted) {
+        RecordTrace(TraceEvent::Kind::Job, true, now);
+        RecordTrace(TraceEvent::Kind::Step, true, now);
+        RecordTrace(TraceEvent::Kind::Group, true, now);
+        m_IsStarted = true;
+        m_StartTime = now;
+        m_CurrentGroupStartTime = now;
+        return false;
+    }
+    assert(!m_IsFinished);
+    if (m_IsFastForwarding) {
+        assert(now == GetNextEvent(now));
+        m_IsFastForwarding = false;
+        auto remainingStepCount = *StepCount - m_FastForwardStepIdx;
+        (m_FastForwardUseSharp ? m_DurationWithSharp : m_DurationWithoutSharp) +=
+            remainingStepCount * m_Model->StepTransmissionDuration[m_FastForwardUseSharp];
+        m_CurrentStepIdx = *StepCount;
+        m_CurrentGroupIdx = 0;
+        m_CurrentOpIdx = 0;
+        m_IsFinished = true;
+        m_FinishTime = now;
+        return true;
+    }
+    assert(!StepCount || m_CurrentStepIdx < *StepCount);
+    assert(m_CurrentGroupIdx < CommOpGroups.size());
+    const auto &opGroup = CommOpGroups[m_CurrentGroupIdx];
+    if (m_CurrentOpIdx >= opGroup.CommOps.size()) {
+        assert(!m_IsRunning);
+        assert(now >= m_CurrentGroupStartTime + opGroup.SyncTime);
+        RecordTrace(TraceEvent::Kind::Group, false, now);
+        m_CurrentOpIdx = 0;
+        ++m_CurrentGroupIdx;
+        if (m_CurrentGroupIdx >= CommOpGroups.size()) {
+            RecordTrace(TraceEvent::Kind::Step, false, now);
+            m_CurrentGroupIdx = 0;
+            ++m_CurrentStepIdx;
+            if (StepCount && m_CurrentStepIdx >= *StepCount) {
+                RecordTrace(TraceEvent::Kind::Job, false, now);
+                m_IsFinished = true;
+                m_FinishTime = now;
+                return true;
+            }
+            RecordTrace(TraceEvent::Kind::Step, true, now);
+        }
+        RecordTrace(TraceEvent::Kind::Group, true, now);
+        m_CurrentGroupStartTime = now;
+        return false;
+    }
+    const auto &op = opGroup.CommOps[m_CurrentOpIdx];
+    if (m_IsRunning) {
+        assert(now == m_CurrentTransmissionStartTime + m_CurrentTransmissionDuration);
+        RecordTrace(TraceEvent::Kind::Transmission, false, now);
+        m_IsRunning = false;
+        m_CurrentOpTransmittedMessageSize += m_TransmittingMessageSize;
+        assert(m_CurrentOpTransmittedMessageSize <= op.MessageSize);
+        if (m_CurrentOpTransmittedMessageSize == op.MessageSize) {
+            RecordTrace(TraceEvent::Kind::CommOp, false, now);
+            m_CurrentOpTransmittedMessageSize = 0;
+            ++m_CurrentOpIdx;
+        }
+        (m_IsUsingSharp ? m_DurationWithSharp : m_DurationWithoutSharp) += m_CurrentTransmissionDuration;
+        hooks.AfterTransmission(*this, now);
+        if (m_NextAggrTree) {
+            if (*m_NextCompactAggrTree != m_CompactAggrTree)
+                ++m_TreeMigrationCount;
+            m_AggrTree = std::move(*m_NextAggrTree);
+            m_NextAggrTree = std::nullopt;
+            m_CompactAggrTree = std::move(*m_NextCompactAggrTree);
+            m_NextCompactAggrTree = std::nullopt;
+        }
+        return false;
+    }
+    if (m_CurrentOpTransmittedMessageSize == 0 && now != m_WaitingUntilTime)
+        RecordTrace(TraceEvent::Kind::CommOp, true, now);
+    auto scheduleRes = hooks.BeforeTransmission(*this, now);
+    if (scheduleRes.InsertWaitingTime) {
+        RecordTrace(TraceEvent::Kind::Waiting, true, now);
+        m_WaitingUntilTime = now + scheduleRes.WaitingTime;
+        return false;
+    }
+    if (now == m_WaitingUntilTime) {
+        RecordTrace(TraceEvent::Kind::Waiting, false, now);
+        m_WaitingUntilTime = 0.0;
+    }
+    assert(!scheduleRes.UseSharp || m_AggrTree);
+    m_IsRunning = true;
+    m_IsUsingSharp = scheduleRes.UseSharp;
+    m_TransmittingMessageSize = scheduleRes.MessageSize;
+    if (m_TransmittingMessageSize == -1ull)
+        m_TransmittingMessageSize = op.MessageSize - m_CurrentOpTransmittedMessageSize;
+    assert(m_CurrentOpTransmittedMessageSize + m_TransmittingMessageSize <= op.MessageSize);
+    if (m_TransmittingMessageSize == op.MessageSize)
+        m_CurrentTransmissionDuration =
+            m_Model->CommOpTimings[m_CurrentGroupIdx][m_CurrentOpIdx].Duration[m_IsUsingSharp];
+    else
+        m_CurrentTransmissionDuration =
+            m_Model->CalcTransmissionDuration(op.OpType, m_TransmittingMessageSize, m_IsUsingSharp, HostCount);
+    m_CurrentTransmissionStartTime = now;
+    RecordTrace(TraceEvent::Kind::Transmission, true, now);
+    return false;
+}
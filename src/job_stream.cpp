@@ -0,0 +1,47 @@
+#include "job_stream.hpp"
+#include <cassert>
+
+JobStream::Reader::Reader(std::shared_ptr<JobStream> stream, unsigned long long position)
+    : m_Stream(std::move(stream)), m_Position(position) {
+    std::lock_guard lock(m_Stream->m_Mutex);
+    assert(position >= m_Stream->m_FirstPosition);
+    m_Stream->m_ReaderPositions.insert(position);
+}
+
+JobStream::Reader::~Reader() {
+    std::lock_guard lock(m_Stream->m_Mutex);
+    m_Stream->m_ReaderPositions.erase(m_Stream->m_ReaderPositions.find(m_Position));
+}
+
+std::unique_ptr<Job> JobStream::Reader::ReadNext() {
+    auto &stream = *m_Stream;
+    std::lock_guard lock(stream.m_Mutex);
+    auto jobIdx = m_Position - stream.m_FirstPosition;
+    if (jobIdx == stream.m_Jobs.size()) {
+        if (stream.m_IsSourceEnded)
+            return nullptr;
+        auto job = stream.m_GetNextJob();
+        if (!job) {
+            stream.m_IsSourceEnded = true;
+            return nullptr;
+        }
+        stream.m_Jobs.push_back(std::move(job));
+    }
+    auto job = std::make_unique<Job>(*stream.m_Jobs[jobIdx]);
+    stream.m_ReaderPositions.erase(stream.m_ReaderPositions.find(m_Position));
+    stream.m_ReaderPositions.insert(++m_Position);
+    // Drop the jobs every reader has taken
+    while (stream.m_FirstPosition < *stream.m_ReaderPositions.begin()) {
+        stream.m_Jobs.pop_front();
+        ++stream.m_FirstPosition;
+    }
+    return job;
+}
+
+std::shared_ptr<JobStream::Reader> JobStream::Reader::Clone() const {
+    return std::make_shared<Reader>(m_Stream, m_Position);
+}
+
+std::shared_ptr<JobStream::Reader> JobStream::Create(std::function<std::unique_ptr<Job>()> &&getNextJob) {
+    return std::make_shared<Reader>(std::make_shared<JobStream>(std::move(getNextJob)), 0);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "job.hpp"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+
+// Hands the jobs of one source to several readers, e.g. the forks of a simulation, each of which gets its own copies of
+// the same jobs with the same IDs in the same order. Jobs are kept until every reader has taken them. The source is
+// called by whichever reader gets ahead first, so it must not depend on the thread it is called on.
+class JobStream {
+public:
+    class Reader {
+    private:
+        std::shared_ptr<JobStream> m_Stream;
+        unsigned long long m_Position;
+
+    public:
+        explicit Reader(std::shared_ptr<JobStream> stream, unsigned long long position);
+        ~Reader();
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        // Returns a copy of the next job if exists, nullptr if not.
+        std::unique_ptr<Job> ReadNext();
+        // Returns another reader at the same position.
+        std::shared_ptr<Reader> Clone() const;
+    };
+
+    // Returns the first reader of a stream of the jobs of the source.
+    static std::shared_ptr<Reader> Create(std::function<std::unique_ptr<Job>()> &&getNextJob);
+
+    explicit JobStream(std::function<std::unique_ptr<Job>()> &&getNextJob) : m_GetNextJob(std::move(getNextJob)) {}
+
+private:
+    std::mutex m_Mutex;
+    std::function<std::unique_ptr<Job>()> m_GetNextJob;
+    bool m_IsSourceEnded = false;
+    // The jobs taken from the source that some reader has not taken yet, the first of which is at m_FirstPosition.
+    std::deque<std::unique_ptr<Job>> m_Jobs;
+    unsigned long long m_FirstPosition = 0;
+    std::multiset<unsigned long long> m_ReaderPositions;
+};
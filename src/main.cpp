@@ -1,9 +1,65 @@
 #include "experiments/experiments.hpp"
+#include "experiments/sweep.hpp"
+#include "simulation_service.hpp"
 
 int main(int argc, const char *argv[]) {
-    if (argc != 2)
+    if (argc < 2)
         return 1;
     std::string name = argv[1];
+    // Usage: convert-profiles <profile path> [model file paths...], which converts every model if none is given
+    if (name == "convert-profiles") {
+        if (argc < 3)
+            return 1;
+        std::vector<const char *> modelInfoPaths(argv + 3, argv + argc);
+        if (modelInfoPaths.empty())
+            modelInfoPaths = AllModelList;
+        return ModelRegistry::ConvertProfiles(modelInfoPaths, argv[2]) ? 0 : 1;
+    }
+    // Usage: sweep <grid path> <output path> [worker count], which resumes from the runs already in the output file
+    if (name == "sweep") {
+        if (argc < 4)
+            return 1;
+        std::ifstream file(argv[2]);
+        SweepRunner runner(nlohmann::ordered_json::parse(file));
+        if (argc >= 5)
+            runner.WorkerCount = std::stoul(argv[4]);
+        runner.Run(argv[3], true);
+        return 0;
+    }
+    // Usage: replicate <replication path> <output path> [worker count], which writes the report to the output file
+    if (name == "replicate") {
+        if (argc < 4)
+            return 1;
+        std::ifstream file(argv[2]);
+        ReplicationRunner runner(nlohmann::json::parse(file));
+        if (argc >= 5)
+            runner.WorkerCount = std::stoul(argv[4]);
+        auto report = runner.Run();
+        std::ofstream(argv[3]) << report.dump(4) << std::endl;
+        const auto &targetMetric = report["target_metric"].get_ref<const std::string &>();
+        std::cout << report["replica_count"] << " replicas, " << targetMetric << " at " << report["confidence"]
+                  << " confidence:" << std::endl;
+        for (const auto &configuration : report["configurations"]) {
+            const auto &interval = configuration["metrics"][targetMetric];
+            std::cout << "  " << interval["mean"] << " +- " << interval["half_width"];
+            if (configuration.contains("differences")) {
+                const auto &difference = configuration["differences"][targetMetric];
+                std::cout << ", " << difference["mean"] << " +- " << difference["half_width"] << " from the first";
+            }
+            std::cout << std::endl;
+        }
+        return 0;
+    }
+    // Usage: serve [--socket <socket path>], which replies to requests on stdin or on a Unix domain socket
+    if (name == "serve") {
+        SetDurationModel(DurationCaculator(12'500'000'000, 2.0, 0.000'05));
+        SimulationService service(*LoadedModels, 1.0);
+        if (argc >= 4 && std::string(argv[2]) == "--socket")
+            service.ServeUnixSocket(argv[3]);
+        else
+            service.Serve(std::cin, std::cout);
+        return 0;
+    }
     if (name == "large-scale-simulation")
         TestLargeScaleSimulation();
     else if (name == "ablation-study")
@@ -20,5 +76,17 @@ int main(int argc, const char *argv[]) {
         TestAccelerateEffectiveness();
     else if (name == "sharing-overhead")
         TestSharingOverhead();
+    else if (name == "parallel-scaling")
+        TestParallelScaling();
+    else if (name == "policy-specialization")
+        TestPolicySpecialization();
+    else if (name == "trace-overhead")
+        TestTraceOverhead();
+    else if (name == "workload-replay")
+        TestWorkloadReplay(argc >= 3 ? argv[2] : "../data/workload.csv");
+    else if (name == "checkpoint")
+        TestCheckpoint(argc >= 3 ? argv[2] : "../data/workload.csv");
+    else if (name == "what-if")
+        TestWhatIf(argc >= 3 ? argv[2] : "../data/workload.csv");
     return 0;
 }
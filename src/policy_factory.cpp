@@ -0,0 +1,58 @@
+#include "policy_factory.hpp"
+#include "host_allocation_policies/first.hpp"
+#include "host_allocation_policies/random.hpp"
+#include "host_allocation_policies/smart.hpp"
+#include "sharing_policies/greedy.hpp"
+#include "sharing_policies/non_sharp.hpp"
+#include "sharing_policies/smart.hpp"
+#include "tree_building_policies/first.hpp"
+#include "tree_building_policies/none.hpp"
+#include "tree_building_policies/random.hpp"
+#include "tree_building_policies/smart.hpp"
+#include <stdexcept>
+#include <string>
+
+static std::string GetPolicyName(const nlohmann::json &spec) {
+    return spec.is_object() ? spec.at("name").get<std::string>() : spec.get<std::string>();
+}
+
+AllocationController::HostAllocationPolicy CreateHostAllocationPolicy(const nlohmann::json &spec) {
+    auto name = GetPolicyName(spec);
+    if (name == "first")
+        return FirstHostAllocationPolicy();
+    if (name == "random")
+        return RandomHostAllocationPolicy();
+    if (name == "smart")
+        return SmartHostAllocationPolicy(spec.is_object() ? spec.value("alpha", 0.5) : 0.5);
+    throw std::runtime_error("Unknown host allocation policy " + name);
+}
+
+AllocationController::TreeBuildingPolicy CreateTreeBuildingPolicy(const nlohmann::json &spec) {
+    auto name = GetPolicyName(spec);
+    if (name == "first")
+        return FirstTreeBuildingPolicy();
+    if (name == "random")
+        return RandomTreeBuildingPolicy();
+    if (name == "none")
+        return NoneTreeBuildingPolicy();
+    if (name == "smart") {
+        std::optional<unsigned int> maxTreeCount = 5;
+        if (spec.is_object() && spec.contains("max_tree_count")) {
+            const auto &value = spec["max_tree_count"];
+            maxTreeCount = value.is_null() ? std::nullopt : std::optional(value.get<unsigned int>());
+        }
+        return SmartTreeBuildingPolicy(maxTreeCount);
+    }
+    throw std::runtime_error("Unknown tree building policy " + name);
+}
+
+AllocationController::SharingPolicy CreateSharingPolicy(const nlohmann::json &spec) {
+    auto name = GetPolicyName(spec);
+    if (name == "greedy")
+        return GreedySharingPolicy();
+    if (name == "smart")
+        return SmartSharingPolicy();
+    if (name == "non_sharp")
+        return NonSharpSharingPolicy();
+    throw std::runtime_error("Unknown sharing policy " + name);
+}
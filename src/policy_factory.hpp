@@ -0,0 +1,15 @@
+#pragma once
+
+#include "allocation_controller.hpp"
+#include <nlohmann/json.hpp>
+
+// Each policy is given by its name, e.g. "smart", or by an object with its name and parameters, e.g.
+// {"name": "smart", "alpha": 0.5}, where the parameters left out take the values of the experiments. Throws
+// std::runtime_error on an unknown name.
+
+// "first", "random" or "smart" with "alpha".
+AllocationController::HostAllocationPolicy CreateHostAllocationPolicy(const nlohmann::json &spec);
+// "first", "random", "none" or "smart" with "max_tree_count", which is null for no limit.
+AllocationController::TreeBuildingPolicy CreateTreeBuildingPolicy(const nlohmann::json &spec);
+// "greedy", "smart" or "non_sharp".
+AllocationController::SharingPolicy CreateSharingPolicy(const nlohmann::json &spec);
@@ -1,51 +1,51 @@
 #include "sharing_group.hpp"
+#include "utils/binary_stream.hpp"
+#include <algorithm>
 #include <cassert>
-#include <chrono>
-
-SharingGroup::SharingGroup(std::vector<Job *> &&jobs, FatTreeResource *resources,
-                           const decltype(m_SharingPolicy) &sharingPolicy)
-    : m_Resources(resources), m_SharingPolicy(sharingPolicy), Jobs(std::move(jobs)) {
-    for (auto job : Jobs) {
-        // TODO: Migrating
-        job->SetBeforeTransmissionCallback([this](const Job &job, double now) -> CommOpScheduleResult {
-            std::chrono::high_resolution_clock::time_point startTime, endTime;
-            if (RecordSharingOverhead)
-                startTime = std::chrono::high_resolution_clock::now();
-            auto res = m_SharingPolicy(*this, job, now);
-            if (RecordSharingOverhead) {
-                endTime = std::chrono::high_resolution_clock::now();
-                ++SharingPolicyCallCount;
-                SharingPolicyOverhead +=
-                    std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
-            }
-            if (!res.InsertWaitingTime)
-                m_BeforeTransmissionCallback(job, now, res.UseSharp);
-            if (RecordSharingOverhead && Jobs.size() > 1)
-                for (auto j : Jobs)
-                    j->IncrementConsensusCount();
-            return res;
-        });
-        job->SetAfterTransmissionCallback([this](const Job &job, double now) {
-            m_AfterTransmissionCallback(job, now, job.IsUsingSharp());
-            if (RecordSharingOverhead && Jobs.size() > 1)
-                for (auto j : Jobs)
-                    j->IncrementConsensusCount();
-        });
-    }
-}
-
-std::pair<double, Job *> SharingGroup::GetNextEvent(double now) const {
-    double nearestEventTime;
-    Job *nearestJob = nullptr;
-    for (auto job : Jobs) {
-        auto nextEventTime = job->GetNextEvent(now);
-        if (!nearestJob || nextEventTime < nearestEventTime) {
-            nearestEventTime = nextEventTime;
-            nearestJob = job;
-        }
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+SharingGroup::SharingGroup(std::vector<Job *> &&jobs, FatTreeResource *resources, SimulationContext *context,
+                           double now)
+    : m_Resources(resources), m_Context(context), Jobs(std::move(jobs)) {
+    for (unsigned int i = 0; i < Jobs.size(); ++i) {
+        m_JobIndices[Jobs[i]] = i;
+        m_EventHeap.Push(i, {Jobs[i]->GetNextEvent(now), Jobs[i]->ID});
+    }
+}
+
+SharingGroup::SharingGroup(const SharingGroup &other, std::vector<Job *> &&jobs, FatTreeResource *resources,
+                           SimulationContext *context)
+    : m_Resources(resources), m_Context(context), m_EventHeap(other.m_EventHeap), m_Snapshots(other.m_Snapshots),
+      Jobs(std::move(jobs)) {
+    assert(!other.m_SkippedPeriod);
+    assert(Jobs.size() == other.Jobs.size());
+    for (unsigned int i = 0; i < Jobs.size(); ++i) {
+        assert(Jobs[i]->ID == other.Jobs[i]->ID);
+        m_JobIndices[Jobs[i]] = i;
     }
-    assert(nearestJob);
-    return {nearestEventTime, nearestJob};
+}
+
+std::pair<double, Job *> SharingGroup::GetNextEvent() const {
+    if (m_SkippedPeriod)
+        return {GetNextEventKey().first, Jobs.front()};
+    assert(!m_EventHeap.Empty());
+    return {m_EventHeap.TopKey().first, Jobs[m_EventHeap.TopHandle()]};
+}
+
+SharingGroup::EventKey SharingGroup::GetNextEventKey() const {
+    if (m_SkippedPeriod) {
+        const auto &[begin, end] = *m_SkippedPeriod;
+        return {end.Time + m_MaxSkippedPeriodCount * (end.Time - begin.Time), Jobs.front()->ID};
+    }
+    return m_EventHeap.TopKey();
+}
+
+void SharingGroup::UpdateNextEvent(double now, const Job &job) {
+    // Keys are clamped to the time they are computed at. This is exact since no key is ever smaller than the time of
+    // the earliest event, which is the time the simulation advances to.
+    m_EventHeap.Update(m_JobIndices.at(&job), {job.GetNextEvent(now), job.ID});
 }
 
 bool SharingGroup::CanUseSharp(const Job &job) const {
@@ -54,6 +54,95 @@ bool SharingGroup::CanUseSharp(const Job &job) const {
     for (auto j : Jobs)
         if (j->IsRunning() && j->IsUsingSharp())
             return false;
-    const auto &aggrTree = job.GetCurrentAggrTree();
+    const auto &aggrTree = job.GetCurrentCompactAggrTree();
     return aggrTree && !m_Resources->CheckTreeConflict(*aggrTree);
 }
+
+bool SharingGroup::IsTraced() const {
+    return std::any_of(Jobs.cbegin(), Jobs.cend(), [](const Job *job) { return job->IsTraced(); });
+}
+
+bool SharingGroup::TrySkipPeriods(double now, const Job &job) {
+    assert(!m_SkippedPeriod);
+    if (&job != Jobs.front() || !job.IsAtStepBeginning(now) || IsTraced())
+        return false;
+    Snapshot snapshot{now, {}};
+    snapshot.Phases.reserve(Jobs.size());
+    for (auto j : Jobs) {
+        if (!j->IsStarted())
+            return false;
+        snapshot.Phases.push_back(j->GetPhase(now));
+    }
+    for (auto iter = m_Snapshots.rbegin(); iter != m_Snapshots.rend(); ++iter) {
+        if (now <= iter->Time)
+            continue;
+        bool isSamePhase = true;
+        for (unsigned int i = 0; i < Jobs.size() && isSamePhase; ++i)
+            isSamePhase = snapshot.Phases[i].IsSamePhase(iter->Phases[i], PeriodTolerance);
+        if (!isSamePhase)
+            continue;
+        // Skip as many periods as possible without finishing any job
+        unsigned long long maxPeriodCount = std::numeric_limits<unsigned int>::max();
+        for (unsigned int i = 0; i < Jobs.size(); ++i) {
+            auto stepIdx = snapshot.Phases[i].StepIdx;
+            auto stepCount = stepIdx - iter->Phases[i].StepIdx;
+            if (stepCount == 0)
+                maxPeriodCount = 0;
+            else if (Jobs[i]->StepCount)
+                maxPeriodCount =
+                    std::min<unsigned long long>(maxPeriodCount, (*Jobs[i]->StepCount - 1 - stepIdx) / stepCount);
+        }
+        if (maxPeriodCount == 0)
+            break;
+        m_SkippedPeriod.emplace(std::move(*iter), std::move(snapshot));
+        m_MaxSkippedPeriodCount = maxPeriodCount;
+        m_Snapshots.clear();
+        return true;
+    }
+    m_Snapshots.push_back(std::move(snapshot));
+    if (m_Snapshots.size() > MaxPeriodStepCount)
+        m_Snapshots.pop_front();
+    return false;
+}
+
+void SharingGroup::ApplySkippedPeriods(const EventKey &lastEvent) {
+    assert(m_SkippedPeriod);
+    auto [begin, end] = std::move(*m_SkippedPeriod);
+    m_SkippedPeriod.reset();
+    auto period = end.Time - begin.Time;
+    // Each period ends with an event of the first job
+    auto firstJobId = Jobs.front()->ID;
+    unsigned int periodCount = 0;
+    if (lastEvent.first > end.Time) {
+        periodCount = std::min<double>(std::floor((lastEvent.first - end.Time) / period), m_MaxSkippedPeriodCount);
+        while (periodCount > 0 && EventKey{end.Time + periodCount * period, firstJobId} > lastEvent)
+            --periodCount;
+    }
+    for (unsigned int i = 0; i < Jobs.size(); ++i)
+        Jobs[i]->SkipPeriods(begin.Phases[i], end.Phases[i], period, periodCount);
+    auto now = end.Time + periodCount * period;
+    for (auto job : Jobs)
+        UpdateNextEvent(now, *job);
+}
+
+void SharingGroup::SaveState(BinaryWriter &writer) const {
+    assert(!m_SkippedPeriod);
+    writer.Write<std::uint64_t>(m_Snapshots.size());
+    for (const auto &snapshot : m_Snapshots) {
+        writer.Write(snapshot.Time);
+        writer.WriteVector(snapshot.Phases);
+    }
+}
+
+void SharingGroup::LoadState(BinaryReader &reader) {
+    assert(!m_SkippedPeriod);
+    m_Snapshots.clear();
+    auto snapshotCount = reader.Read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < snapshotCount; ++i) {
+        auto &snapshot = m_Snapshots.emplace_back();
+        snapshot.Time = reader.Read<double>();
+        snapshot.Phases = reader.ReadVector<JobPhase>();
+        if (snapshot.Phases.size() != Jobs.size())
+            throw std::runtime_error("Snapshot of a different sharing group");
+    }
+}
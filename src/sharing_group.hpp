@@ -2,43 +2,149 @@
 
 #include "fat_tree_resource.hpp"
 #include "job.hpp"
+#include "simulation_context.hpp"
+#include "utils/indexed_heap.hpp"
+#include <cassert>
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+class BinaryReader;
+class BinaryWriter;
+
 class SharingGroup {
+public:
+    // The time of the event and the ID of the job, so that simultaneous events are ordered by job ID.
+    using EventKey = std::pair<double, unsigned int>;
+
 private:
     FatTreeResource *m_Resources;
+    SimulationContext *m_Context;
+    // The next event of each job, indexed by the position of the job in Jobs.
+    IndexedHeap<EventKey> m_EventHeap;
+    std::unordered_map<const Job *, unsigned int> m_JobIndices;
 
-    // Given the job, the current time, and whether to use SHARP, returns nothing.
-    std::function<void(const Job &, double, bool)> m_BeforeTransmissionCallback = [](const Job &, double, bool) {};
-    // Given the job, the current time, and whether to use SHARP, returns nothing.
-    std::function<void(const Job &, double, bool)> m_AfterTransmissionCallback = [](const Job &, double, bool) {};
-    // Given the sharing group, the job, and the current time, returns CommOpScheduleResult.
-    std::function<CommOpScheduleResult(const SharingGroup &, const Job &, double)> m_SharingPolicy;
+    struct Snapshot {
+        double Time;
+        std::vector<JobPhase> Phases;
+    };
+    // Snapshots taken right after the first job begins a step, the latest last.
+    std::deque<Snapshot> m_Snapshots;
+    // The beginning and the end of the period being skipped, skipping started at the end.
+    std::optional<std::pair<Snapshot, Snapshot>> m_SkippedPeriod;
+    unsigned int m_MaxSkippedPeriodCount;
+
+    // Stops skipping at the end of the last whole period that ends before the given event.
+    void ApplySkippedPeriods(const EventKey &lastEvent);
 
 public:
-    inline static bool RecordSharingOverhead = false;
-    inline static unsigned int SharingPolicyCallCount = 0;
-    inline static unsigned long long SharingPolicyOverhead = 0; // In nanosecond
+    static constexpr unsigned int MaxPeriodStepCount = 16; // In steps of the first job
+    static constexpr double PeriodTolerance = 1e-9;        // In second
 
     const std::vector<Job *> Jobs;
 
-    explicit SharingGroup(std::vector<Job *> &&jobs, FatTreeResource *resources,
-                          const decltype(m_SharingPolicy) &sharingPolicy);
+    // The resources and the context are those of the simulation, which records the sharing overhead in the context.
+    explicit SharingGroup(std::vector<Job *> &&jobs, FatTreeResource *resources, SimulationContext *context,
+                          double now);
+    // Copies the group onto the copies of its jobs in the same order, which must not be skipping.
+    explicit SharingGroup(const SharingGroup &other, std::vector<Job *> &&jobs, FatTreeResource *resources,
+                          SimulationContext *context);
 
+    bool Empty() const { return m_EventHeap.Empty(); }
     // Returns the time of the next event and the job that will run next.
-    std::pair<double, Job *> GetNextEvent(double now) const;
-    // Returns whether the job is finished.
-    bool RunNextEvent(double now, Job *job) { return job->RunNextEvent(now); }
+    std::pair<double, Job *> GetNextEvent() const;
+    EventKey GetNextEventKey() const;
+    // Returns whether the job is finished. The sharing policy is called with the sharing group, the job, and the
+    // current time, and returns CommOpScheduleResult. THooks provides BeforeTransmission and AfterTransmission, which
+    // are called with the job, the current time, and whether to use SHARP. Both are called directly so that a
+    // controller specialized on them can have them inlined.
+    template <typename TSharingPolicy, typename THooks>
+    bool RunNextEvent(double now, Job *job, const TSharingPolicy &sharingPolicy, THooks &hooks);
+    // Re-keys the next event of the job, must be called whenever the state of a job is changed outside RunNextEvent.
+    void UpdateNextEvent(double now, const Job &job);
 
-    bool CanUseSharp(const Job &job) const;
+    // Records the state of the jobs right after the first job begins a step, and starts skipping whole periods if the
+    // state repeats an earlier record with relative times within PeriodTolerance. Returns whether skipping is started.
+    // While skipping, the next event is the end of the last period before any job finishes, which must be run by
+    // StopSkipping.
+    bool TrySkipPeriods(double now, const Job &job);
+    bool IsSkipping() const { return m_SkippedPeriod.has_value(); }
+    // Leaves the jobs in the state they would be in if all their events up to the given one had been run one by one,
+    // up to the tolerance of the match and the rounding of the period times extrapolated as multiples of the period.
+    // Returns the number of events replayed in the last period, which are run through the sharing policy.
+    template <typename TSharingPolicy, typename THooks>
+    unsigned long long StopSkipping(const EventKey &lastEvent, const TSharingPolicy &sharingPolicy, THooks &hooks);
 
+    bool CanUseSharp(const Job &job) const;
+    // Returns whether any job records its events, which must then be run one by one and on one thread at a time.
+    bool IsTraced() const;
     FatTreeResource *GetFatTreeResources() const { return m_Resources; }
 
-    void SetBeforeTransmissionCallback(const decltype(m_BeforeTransmissionCallback) &callback) {
-        m_BeforeTransmissionCallback = callback;
-    }
-    void SetAfterTransmissionCallback(const decltype(m_AfterTransmissionCallback) &callback) {
-        m_AfterTransmissionCallback = callback;
-    }
+    // Writes the snapshots that periods are detected from, which must not be skipping. The jobs are left to their
+    // owner, and a group created again with the same jobs at the same time has the same events.
+    void SaveState(BinaryWriter &writer) const;
+    // Reads what SaveState writes into a group of the same number of jobs. Throws std::runtime_error if it does not
+    // fit.
+    void LoadState(BinaryReader &reader);
 };
+
+template <typename TSharingPolicy, typename THooks>
+bool SharingGroup::RunNextEvent(double now, Job *job, const TSharingPolicy &sharingPolicy, THooks &hooks) {
+    assert(!m_SkippedPeriod);
+    struct JobHooks {
+        SharingGroup &Group;
+        const TSharingPolicy &SharingPolicy;
+        THooks &Hooks;
+
+        CommOpScheduleResult BeforeTransmission(const Job &job, double now) {
+            auto &context = *Group.m_Context;
+            std::chrono::high_resolution_clock::time_point startTime, endTime;
+            if (context.RecordSharingOverhead)
+                startTime = std::chrono::high_resolution_clock::now();
+            auto res = SharingPolicy(Group, job, now);
+            if (context.RecordSharingOverhead) {
+                endTime = std::chrono::high_resolution_clock::now();
+                ++context.SharingPolicyCallCount;
+                context.SharingPolicyOverhead +=
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+            }
+            if (!res.InsertWaitingTime)
+                Hooks.BeforeTransmission(job, now, res.UseSharp);
+            if (context.RecordSharingOverhead && Group.Jobs.size() > 1)
+                for (auto j : Group.Jobs)
+                    j->IncrementConsensusCount();
+            return res;
+        }
+        void AfterTransmission(const Job &job, double now) {
+            Hooks.AfterTransmission(job, now, job.IsUsingSharp());
+            if (Group.m_Context->RecordSharingOverhead && Group.Jobs.size() > 1)
+                for (auto j : Group.Jobs)
+                    j->IncrementConsensusCount();
+        }
+    } jobHooks{*this, sharingPolicy, hooks};
+    auto jobFinished = job->RunNextEvent(now, jobHooks);
+    if (jobFinished)
+        m_EventHeap.Erase(m_JobIndices.at(job));
+    else
+        UpdateNextEvent(now, *job);
+    return jobFinished;
+}
+
+template <typename TSharingPolicy, typename THooks>
+unsigned long long SharingGroup::StopSkipping(const EventKey &lastEvent, const TSharingPolicy &sharingPolicy,
+                                              THooks &hooks) {
+    ApplySkippedPeriods(lastEvent);
+    // Run the rest of the last period event by event
+    unsigned long long eventCount = 0;
+    while (m_EventHeap.TopKey() < lastEvent) {
+        auto [time, job] = GetNextEvent();
+        [[maybe_unused]] auto jobFinished = RunNextEvent(time, job, sharingPolicy, hooks);
+        assert(!jobFinished);
+        ++eventCount;
+    }
+    return eventCount;
+}
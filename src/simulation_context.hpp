@@ -0,0 +1,44 @@
+#pragma once
+
+#include "utils/philox.hpp"
+#include <cstdint>
+
+// The parts of a simulation that draw random numbers, each with streams of its own.
+enum class RandomSubsystem : std::uint32_t {
+    Workload,
+    HostAllocation,
+    TreeBuilding,
+};
+
+// Returns the stream of the draws that the subsystem makes for the job in the round, which is keyed by the seed and the
+// subsystem and selected by the job ID and the round, so any job's draws can be made again without the draws before.
+inline PhiloxEngine CreateRandomEngine(unsigned int seed, RandomSubsystem subsystem, unsigned int jobID,
+                                       unsigned int round = 0) {
+    return PhiloxEngine(static_cast<std::uint64_t>(subsystem) << 32 | seed,
+                        static_cast<std::uint64_t>(round) << 32 | jobID);
+}
+
+// The state that the jobs, the sharing groups and the policies of one simulation share, which belongs to that
+// simulation alone so that simulations with different settings can run at the same time on any threads with the same
+// results. Each controller owns one and a fork gets a copy. The duration model is not part of it, as it is carried by
+// the model of each job.
+struct SimulationContext {
+    // The ID given to the next job taken or submitted, so that the jobs of a simulation are numbered from 0.
+    unsigned int NextJobID = 0;
+
+    // Whether to time the calls to the sharing policy and count the consensus of the jobs sharing a group.
+    bool RecordSharingOverhead = false;
+    unsigned int SharingPolicyCallCount = 0;
+    unsigned long long SharingPolicyOverhead = 0; // In nanosecond
+
+    // The seed of the random choices of the policies, which draw from the streams of the jobs they choose for, so the
+    // choices do not depend on the thread or on the order the jobs are seen in.
+    unsigned int Seed = 42;
+    // The number of calls to the tree building policies that choose for every running job, each drawing from a round
+    // of streams of its own.
+    unsigned int TreeBuildingRound = 0;
+
+    PhiloxEngine GetRandomEngine(RandomSubsystem subsystem, unsigned int jobID, unsigned int round = 0) const {
+        return CreateRandomEngine(Seed, subsystem, jobID, round);
+    }
+};
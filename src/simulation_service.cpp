@@ -0,0 +1,312 @@
+#include "simulation_service.hpp"
+#include "policy_factory.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static nlohmann::json ToJson(const SimulationResult &result) {
+    return {
+        {"SimulatedTime", result.SimulatedTime},
+        {"FinishedJobCount", result.FinishedJobCount},
+        {"AllocatedJobCount", result.AllocatedJobCount},
+        {"ClusterUtilization", result.ClusterUtilization},
+        {"JCTScore", result.JCTScore},
+        {"SharpRatio", result.SharpRatio},
+        {"AverageQueueingDelay", result.AverageQueueingDelay},
+        {"MaxQueueingDelay", result.MaxQueueingDelay},
+        {"TreeMigrationCount", result.TreeMigrationCount},
+        {"EventCount", result.EventCount},
+    };
+}
+
+// The largest fat tree of a reset, whose k^3 / 4 hosts and their usage a mirror can hold.
+static constexpr unsigned int MaxFatTreeK = 128;
+
+// Returns the quota in the request, where null means no quota.
+static std::optional<unsigned int> GetQuota(const nlohmann::json &request, const char *key,
+                                            std::optional<unsigned int> defaultQuota) {
+    auto iter = request.find(key);
+    if (iter == request.cend())
+        return defaultQuota;
+    if (iter->is_null())
+        return std::nullopt;
+    return iter->get<unsigned int>();
+}
+
+SimulationService::SimulationService(const ModelRegistry &models, double gpuSpeedupRatio)
+    : m_Models(models), m_GpuSpeedupRatio(gpuSpeedupRatio) {
+    Reset(nlohmann::json::object());
+}
+
+nlohmann::json SimulationService::Reset(const nlohmann::json &request) {
+    auto k = request.value("fat_tree_k", 16u);
+    if (k < 2 || k > MaxFatTreeK || k % 2)
+        throw std::runtime_error("fat_tree_k must be an even number from 2 to " + std::to_string(MaxFatTreeK));
+    auto nodeQuota = GetQuota(request, "node_quota", std::nullopt);
+    auto linkQuota = GetQuota(request, "link_quota", 1);
+    auto policies = ParsePolicies(request);
+    // The controller refers to the topology, so it goes first
+    m_Controller.reset();
+    m_Topology = std::make_unique<FatTree>(k);
+    FatTreeResource resources(*m_Topology, nodeQuota, linkQuota);
+    m_Controller = std::make_unique<AllocationController>(
+        std::move(resources), [] { return std::unique_ptr<Job>(); },
+        CreateHostAllocationPolicy(policies.HostAllocation), CreateTreeBuildingPolicy(policies.TreeBuilding),
+        CreateSharingPolicy(policies.Sharing));
+    m_Controller->EnableFastForward = request.value("fast_forward", true);
+    m_Controller->EnablePeriodSkipping = request.value("period_skipping", true);
+    m_Controller->WorkerCount = request.value("worker_count", 1u);
+    m_Policies = std::move(policies);
+    // Start the clock, so that jobs submitted now are allocated at once
+    m_Controller->AdvanceTo(0.0);
+    return nlohmann::json::object();
+}
+
+std::unique_ptr<Job> SimulationService::CreateJob(const nlohmann::json &request) const {
+    auto model = request.at("model").get<std::string>();
+    auto hostCount = request.at("host_count").get<unsigned int>();
+    auto stepCount = request.at("step_count").get<unsigned int>();
+    auto submitTime = request.value("submit_time", m_Controller->GetNow());
+    if (!m_Models.Contains(model, m_GpuSpeedupRatio))
+        throw std::runtime_error("Unknown model " + model);
+    // A job that can never be allocated would hold up every job behind it
+    if (!hostCount || hostCount > m_Models.GetMaxHostCount() || hostCount > m_Topology->NodesByLayer[0].size())
+        throw std::runtime_error("Job of " + std::to_string(hostCount) + " hosts");
+    if (!stepCount)
+        throw std::runtime_error("Job of no step");
+    auto job = std::make_unique<Job>(stepCount, m_Models.GetJobModel(model, m_GpuSpeedupRatio, hostCount));
+    job->SetSubmitTime(submitTime);
+    return job;
+}
+
+SimulationService::PolicySpecs SimulationService::ParsePolicies(const nlohmann::json &request) const {
+    PolicySpecs policies = {
+        request.value("host_allocation", m_Policies.HostAllocation),
+        request.value("tree_building", m_Policies.TreeBuilding),
+        request.value("sharing", m_Policies.Sharing),
+    };
+    // Fail on unknown names before anything is changed
+    CreateHostAllocationPolicy(policies.HostAllocation);
+    CreateTreeBuildingPolicy(policies.TreeBuilding);
+    CreateSharingPolicy(policies.Sharing);
+    return policies;
+}
+
+nlohmann::json SimulationService::Submit(const nlohmann::json &request) {
+    auto jobId = m_Controller->SubmitJob(CreateJob(request));
+    return {{"job_id", jobId}};
+}
+
+nlohmann::json SimulationService::Advance(const nlohmann::json &request) {
+    auto time = request.at("time").get<double>();
+    if (!(time >= m_Controller->GetNow()))
+        throw std::runtime_error("Cannot advance to " + std::to_string(time) + " before the current time");
+    auto result = m_Controller->AdvanceTo(time);
+    return {{"now", m_Controller->GetNow()}, {"result", ToJson(result)}};
+}
+
+nlohmann::json SimulationService::GetState() const {
+    auto jobs = nlohmann::json::array(), groups = nlohmann::json::array(), pendingJobs = nlohmann::json::array();
+    std::unordered_set<const SharingGroup *> sharingGroups;
+    unsigned int usedHostCount = 0;
+    for (const auto &job : m_Controller->GetRunningJobs()) {
+        usedHostCount += job->HostCount;
+        std::vector<unsigned int> hosts;
+        for (auto host : job->GetHosts())
+            hosts.push_back(host->ID);
+        nlohmann::json aggrTree;
+        if (const auto &tree = job->GetCurrentAggrTree()) {
+            std::vector<unsigned int> nodes, edges;
+            for (auto node : tree->first)
+                nodes.push_back(node->ID);
+            for (auto edge : tree->second)
+                edges.push_back(edge->ID);
+            aggrTree = {{"nodes", nodes}, {"edges", edges}};
+        }
+        const auto &sharingGroup = m_Controller->GetSharingGroup(*job);
+        std::vector<unsigned int> groupJobIds;
+        for (auto groupJob : sharingGroup.Jobs)
+            groupJobIds.push_back(groupJob->ID);
+        if (sharingGroups.insert(&sharingGroup).second)
+            groups.push_back(groupJobIds);
+        jobs.push_back({
+            {"job_id", job->ID},
+            {"host_count", job->HostCount},
+            {"step_count", *job->StepCount},
+            {"step_idx", job->GetCurrentStepIdx()},
+            {"submit_time", job->GetSubmitTime()},
+            {"start_time", job->GetStartTime()},
+            {"hosts", hosts},
+            {"aggr_tree", aggrTree},
+            {"using_sharp", job->IsUsingSharp()},
+            {"sharing_group", groupJobIds},
+        });
+    }
+    for (auto job : m_Controller->GetPendingJobs())
+        pendingJobs.push_back({
+            {"job_id", job->ID},
+            {"host_count", job->HostCount},
+            {"submit_time", job->GetSubmitTime()},
+        });
+    auto hostCount = m_Topology->NodesByLayer[0].size();
+    return {
+        {"now", m_Controller->GetNow()},
+        {"policies",
+         {
+             {"host_allocation", m_Policies.HostAllocation},
+             {"tree_building", m_Policies.TreeBuilding},
+             {"sharing", m_Policies.Sharing},
+         }},
+        {"host_count", hostCount},
+        {"free_host_count", hostCount - usedHostCount},
+        {"jobs", jobs},
+        {"sharing_groups", groups},
+        {"pending_jobs", pendingJobs},
+    };
+}
+
+nlohmann::json SimulationService::SetPolicies(const nlohmann::json &request) {
+    auto policies = ParsePolicies(request);
+    m_Controller->SetHostAllocationPolicy(CreateHostAllocationPolicy(policies.HostAllocation));
+    m_Controller->SetTreeBuildingPolicy(CreateTreeBuildingPolicy(policies.TreeBuilding));
+    m_Controller->SetSharingPolicy(CreateSharingPolicy(policies.Sharing));
+    m_Policies = std::move(policies);
+    return nlohmann::json::object();
+}
+
+nlohmann::json SimulationService::WhatIf(const nlohmann::json &request) {
+    auto time = request.at("time").get<double>();
+    if (!(time >= m_Controller->GetNow()))
+        throw std::runtime_error("Cannot advance to " + std::to_string(time) + " before the current time");
+    auto policies = ParsePolicies(request);
+    std::vector<std::unique_ptr<Job>> jobs;
+    for (const auto &jobRequest : request.value("jobs", nlohmann::json::array()))
+        jobs.push_back(CreateJob(jobRequest));
+    auto fork = m_Controller->Fork(CreateHostAllocationPolicy(policies.HostAllocation),
+                                   CreateTreeBuildingPolicy(policies.TreeBuilding),
+                                   CreateSharingPolicy(policies.Sharing));
+    std::vector<unsigned int> jobIds;
+    for (auto &job : jobs)
+        jobIds.push_back(fork->SubmitJob(std::move(job)));
+    auto result = fork->AdvanceTo(time);
+    return {{"job_ids", jobIds}, {"result", ToJson(result)}};
+}
+
+std::string SimulationService::HandleRequest(const std::string &line) {
+    nlohmann::json reply;
+    nlohmann::json request;
+    try {
+        request = nlohmann::json::parse(line);
+        auto op = request.at("op").get<std::string>();
+        if (op == "submit")
+            reply = Submit(request);
+        else if (op == "advance")
+            reply = Advance(request);
+        else if (op == "state")
+            reply = GetState();
+        else if (op == "result")
+            reply = {{"result", ToJson(m_Controller->GetResult())}};
+        else if (op == "set_policies")
+            reply = SetPolicies(request);
+        else if (op == "what_if")
+            reply = WhatIf(request);
+        else if (op == "reset")
+            reply = Reset(request);
+        else if (op == "shutdown")
+            m_IsShutDown = true;
+        else
+            throw std::runtime_error("Unknown op " + op);
+        reply["ok"] = true;
+    } catch (const std::exception &e) {
+        reply = {{"ok", false}, {"error", e.what()}};
+    }
+    // Lets clients that pipeline requests match the replies
+    if (request.is_object() && request.contains("id"))
+        reply["id"] = request["id"];
+    return reply.dump();
+}
+
+void SimulationService::Serve(std::istream &in, std::ostream &out) {
+    std::string line;
+    while (!m_IsShutDown && std::getline(in, line))
+        if (!line.empty())
+            out << HandleRequest(line) << std::endl;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+static bool WriteAll(int fd, const std::string &data) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    for (std::size_t offset = 0; offset < data.size();) {
+        auto size = send(fd, data.data() + offset, data.size() - offset, flags);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            return false;
+        offset += size;
+    }
+    return true;
+}
+
+void SimulationService::ServeUnixSocket(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Socket path " + path + " is too long");
+    address.sun_family = AF_UNIX;
+    std::copy(path.cbegin(), path.cend(), address.sun_path);
+    auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw std::runtime_error("Cannot create socket");
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 1) < 0) {
+        close(listener);
+        throw std::runtime_error("Cannot listen on " + path);
+    }
+    while (!m_IsShutDown) {
+        auto connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR)
+                continue;
+            close(listener);
+            throw std::runtime_error("Cannot accept connection on " + path);
+        }
+        // Requests may arrive split or batched, so lines are cut out of what has been read
+        std::string buffer;
+        char chunk[4096];
+        bool isConnected = true;
+        while (isConnected && !m_IsShutDown) {
+            auto size = read(connection, chunk, sizeof(chunk));
+            if (size < 0 && errno == EINTR)
+                continue;
+            if (size <= 0)
+                break;
+            buffer.append(chunk, size);
+            std::size_t lineBegin = 0, lineEnd;
+            while (isConnected && !m_IsShutDown && (lineEnd = buffer.find('\n', lineBegin)) != std::string::npos) {
+                auto line = buffer.substr(lineBegin, lineEnd - lineBegin);
+                lineBegin = lineEnd + 1;
+                if (!line.empty())
+                    isConnected = WriteAll(connection, HandleRequest(line) + '\n');
+            }
+            buffer.erase(0, lineBegin);
+        }
+        close(connection);
+    }
+    close(listener);
+    unlink(path.c_str());
+}
+#else
+void SimulationService::ServeUnixSocket(const std::string &) {
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+}
+#endif
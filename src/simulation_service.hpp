@@ -0,0 +1,57 @@
+#pragma once
+
+#include "allocation_controller.hpp"
+#include "data.hpp"
+#include "fat_tree.hpp"
+#include <istream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <ostream>
+#include <string>
+
+// Keeps a simulation that mirrors a live cluster, driven by requests of one JSON object per line with one reply per
+// request. A scheduler submits the jobs it places on the cluster, advances the clock with the cluster, queries the
+// state of the jobs, the sharing groups and the hosts, and asks what would happen under other policies or with more
+// jobs by forking the mirror, which is left as it was. The requests are described in the README.
+class SimulationService {
+private:
+    // Given as to CreateHostAllocationPolicy and the like.
+    struct PolicySpecs {
+        nlohmann::json HostAllocation = "first";
+        nlohmann::json TreeBuilding = "first";
+        nlohmann::json Sharing = "greedy";
+    };
+
+    ModelRegistry m_Models;
+    double m_GpuSpeedupRatio;
+    std::unique_ptr<FatTree> m_Topology;
+    PolicySpecs m_Policies;
+    std::unique_ptr<AllocationController> m_Controller;
+    bool m_IsShutDown = false;
+
+    nlohmann::json Reset(const nlohmann::json &request);
+    nlohmann::json Submit(const nlohmann::json &request);
+    nlohmann::json Advance(const nlohmann::json &request);
+    nlohmann::json GetState() const;
+    nlohmann::json SetPolicies(const nlohmann::json &request);
+    nlohmann::json WhatIf(const nlohmann::json &request);
+    // Creates the job of a submit request, submitted now if it has no submit time.
+    std::unique_ptr<Job> CreateJob(const nlohmann::json &request) const;
+    // Returns the policies named in the request, with the current ones for those it does not name.
+    PolicySpecs ParsePolicies(const nlohmann::json &request) const;
+
+public:
+    // The models of the jobs are looked up in the registry at the GPU speedup ratio. Starts with a fat tree of k = 16,
+    // a link quota of 1 and the policies of the baseline, until a reset request says otherwise.
+    explicit SimulationService(const ModelRegistry &models, double gpuSpeedupRatio);
+
+    // Returns the reply to the request, which is {"ok": false, "error": ...} if the request fails.
+    std::string HandleRequest(const std::string &line);
+    // Whether a shutdown request has been handled.
+    bool IsShutDown() const { return m_IsShutDown; }
+    // Replies to the requests on the stream until it ends or a shutdown request.
+    void Serve(std::istream &in, std::ostream &out);
+    // Listens on a Unix domain socket at the path and replies to one connection at a time until a shutdown request.
+    // Throws std::runtime_error if the socket cannot be listened on or Unix domain sockets are not supported.
+    void ServeUnixSocket(const std::string &path);
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "allocation_controller.hpp"
+#include "host_allocation_policies/first.hpp"
+#include "host_allocation_policies/smart.hpp"
+#include "sharing_policies/greedy.hpp"
+#include "sharing_policies/smart.hpp"
+#include "tree_building_policies/first.hpp"
+#include "tree_building_policies/smart.hpp"
+
+// The controllers specialized on the policies of Mina and of the baseline in the experiments, kept out of
+// allocation_controller.hpp so that code using AllocationController does not depend on the concrete policies. They are
+// instantiated in allocation_controller.cpp.
+using MinaAllocationController =
+    BasicAllocationController<SmartHostAllocationPolicy, SmartTreeBuildingPolicy, SmartSharingPolicy>;
+using BaselineAllocationController =
+    BasicAllocationController<FirstHostAllocationPolicy, FirstTreeBuildingPolicy, GreedySharingPolicy>;
+
+extern template class BasicAllocationController<SmartHostAllocationPolicy, SmartTreeBuildingPolicy,
+                                                SmartSharingPolicy>;
+extern template class BasicAllocationController<FirstHostAllocationPolicy, FirstTreeBuildingPolicy,
+                                                GreedySharingPolicy>;
@@ -0,0 +1,69 @@
+#include "steady_state_monitor.hpp"
+#include "utils/statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void SteadyStateMonitor::AddSample(const SimulationResult &result, unsigned int hostCount) {
+    if (!m_BatchStart) {
+        m_BatchStart = result;
+        m_StartTime = result.SimulatedTime;
+        return;
+    }
+    const auto &start = *m_BatchStart;
+    auto duration = result.SimulatedTime - start.SimulatedTime;
+    auto jct = result.TotalJCT - start.TotalJCT;
+    auto jctWithSharp = result.TotalJCTWithSharp - start.TotalJCTWithSharp;
+    auto jctWithoutSharp = result.TotalJCTWithoutSharp - start.TotalJCTWithoutSharp;
+    // The batch goes on while no job has made progress in it
+    if (!(duration > 0.0) || jct == 0.0 || jctWithSharp == jctWithoutSharp)
+        return;
+    m_BatchValues[0].emplace_back(result.TotalHostTime - start.TotalHostTime, duration * hostCount);
+    m_BatchValues[1].emplace_back(result.TotalSharpTime - start.TotalSharpTime, jct);
+    m_BatchValues[2].emplace_back(jct - jctWithoutSharp, jctWithSharp - jctWithoutSharp);
+    m_BatchEndTimes.push_back(result.SimulatedTime);
+    m_BatchStart = result;
+    m_Report.BatchCount = m_BatchEndTimes.size();
+    // The estimates only change with a new group
+    if (m_BatchEndTimes.size() % BatchesPerGroup == 0)
+        UpdateReport();
+}
+
+void SteadyStateMonitor::UpdateReport() {
+    auto groupCount = static_cast<unsigned int>(m_BatchEndTimes.size() / BatchesPerGroup);
+    std::array<std::vector<double>, MetricCount> groupValues;
+    // The transient of the slowest metric is truncated from all of them
+    unsigned int truncation = 0;
+    auto isTruncationValid = groupCount >= 2;
+    for (unsigned int metricIdx = 0; metricIdx < MetricCount; ++metricIdx) {
+        const auto &values = m_BatchValues[metricIdx];
+        for (unsigned int groupIdx = 0; groupIdx < groupCount; ++groupIdx) {
+            double numerator = 0.0, denominator = 0.0;
+            for (unsigned int i = 0; i < BatchesPerGroup; ++i) {
+                numerator += values[groupIdx * BatchesPerGroup + i].first;
+                denominator += values[groupIdx * BatchesPerGroup + i].second;
+            }
+            groupValues[metricIdx].push_back(numerator / denominator);
+        }
+        auto metricTruncation = CalcMserTruncation(groupValues[metricIdx]);
+        // The minimum at the end of the first half means the metric may still be drifting
+        if (metricTruncation >= groupCount / 2)
+            isTruncationValid = false;
+        truncation = std::max(truncation, metricTruncation);
+    }
+    m_Report.TruncatedBatchCount = truncation * BatchesPerGroup;
+    m_Report.WarmUpTime = truncation ? m_BatchEndTimes[truncation * BatchesPerGroup - 1] : m_StartTime;
+    m_Report.IsConverged = isTruncationValid && groupCount - truncation >= std::max(MinGroupCount, 2u);
+    for (unsigned int metricIdx = 0; metricIdx < MetricCount; ++metricIdx) {
+        auto &estimate = m_Report.Estimates[metricIdx];
+        if (groupCount == 0) {
+            estimate = {std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN()};
+            continue;
+        }
+        const auto &values = groupValues[metricIdx];
+        auto interval = CalcInterval(std::vector<double>(values.cbegin() + truncation, values.cend()), Confidence);
+        estimate = {interval.Mean, interval.HalfWidth};
+        if (!(interval.HalfWidth <= RelativeTolerance * std::abs(interval.Mean)))
+            m_Report.IsConverged = false;
+    }
+}
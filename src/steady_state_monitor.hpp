@@ -0,0 +1,62 @@
+#pragma once
+
+#include "allocation_controller.hpp"
+#include <array>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Estimates the steady-state cluster utilization, SHARP ratio and JCT score of a simulation from the results at the
+// ends of batches of simulated time. Each metric is a ratio of totals, so it is taken over every group of 5 batches as
+// the ratio of their sums. The initial transient is truncated by MSER-5, the rule of White applied to these group
+// values, and the estimates are the means of the rest with their intervals taken as batch means.
+// A controller with a monitor runs in batches and stops once every estimate is precise enough, so a run takes as long
+// as its metrics need rather than until its drain.
+class SteadyStateMonitor {
+public:
+    static constexpr unsigned int MetricCount = 3;
+    static constexpr std::array<const char *, MetricCount> MetricNames = {"ClusterUtilization", "SharpRatio",
+                                                                          "JCTScore"};
+    static constexpr unsigned int BatchesPerGroup = 5;
+
+    struct Estimate {
+        double Mean = 0.0;
+        double HalfWidth = 0.0;
+    };
+
+    struct Report {
+        bool IsConverged = false;
+        // The batches of the whole run and those truncated as the transient, whose end is the warm-up time
+        unsigned int BatchCount = 0;
+        unsigned int TruncatedBatchCount = 0;
+        double WarmUpTime = 0.0;
+        std::array<Estimate, MetricCount> Estimates;
+    };
+
+private:
+    // The result where the current batch began
+    std::optional<SimulationResult> m_BatchStart;
+    double m_StartTime = 0.0;
+    std::vector<double> m_BatchEndTimes;
+    // The numerator and the denominator of each metric over each batch
+    std::array<std::vector<std::pair<double, double>>, MetricCount> m_BatchValues;
+    Report m_Report;
+
+    void UpdateReport();
+
+public:
+    // The simulated time of each batch in seconds. A batch is extended until every metric is defined over it.
+    double BatchDuration = 1.0;
+    // The half-width of the interval of every estimate must be within this fraction of the estimate to converge.
+    double RelativeTolerance = 0.05;
+    double Confidence = 0.95;
+    // The number of groups of 5 batches that must be left after the truncation to converge.
+    unsigned int MinGroupCount = 10;
+
+    // Adds the result from the beginning of the simulation at the end of a batch, on a cluster of the number of hosts.
+    // The first result only begins the first batch.
+    void AddSample(const SimulationResult &result, unsigned int hostCount);
+    bool IsStarted() const { return m_BatchStart.has_value(); }
+    bool IsConverged() const { return m_Report.IsConverged; }
+    const Report &GetReport() const { return m_Report; }
+};
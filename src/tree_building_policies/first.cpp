@@ -1,7 +1,7 @@
 #include "first.hpp"
 
 void FirstTreeBuildingPolicy::operator()(const FatTreeResource &resources, const std::vector<std::unique_ptr<Job>> &,
-                                         const std::vector<Job *> &newJobs) const {
+                                         const std::vector<Job *> &newJobs, SimulationContext &) const {
     for (auto job : newJobs)
         for (auto root : resources.Topology->GetClosestCommonAncestors(job->GetHosts())) {
             auto tree = resources.Topology->GetAggregationTree(job->GetHosts(), root);
@@ -2,11 +2,12 @@
 
 #include "fat_tree_resource.hpp"
 #include "job.hpp"
+#include "simulation_context.hpp"
 #include <memory>
 #include <vector>
 
 class FirstTreeBuildingPolicy {
 public:
     void operator()(const FatTreeResource &resources, const std::vector<std::unique_ptr<Job>> &jobs,
-                    const std::vector<Job *> &newJobs) const;
+                    const std::vector<Job *> &newJobs, SimulationContext &context) const;
 };
@@ -2,7 +2,7 @@
 #include <random>
 
 void RandomTreeBuildingPolicy::operator()(const FatTreeResource &resources, const std::vector<std::unique_ptr<Job>> &,
-                                          const std::vector<Job *> &newJobs) const {
+                                          const std::vector<Job *> &newJobs, SimulationContext &context) const {
     for (auto job : newJobs) {
         std::vector<AggrTree> trees;
         for (auto root : resources.Topology->GetClosestCommonAncestors(job->GetHosts())) {
@@ -11,8 +11,8 @@ void RandomTreeBuildingPolicy::operator()(const FatTreeResource &resources, cons
                 trees.push_back(std::move(tree));
         }
         if (!trees.empty()) {
-            thread_local std::default_random_engine engine(42);
             std::uniform_int_distribution<std::size_t> random(0, trees.size() - 1);
+            auto engine = context.GetRandomEngine(RandomSubsystem::TreeBuilding, job->ID);
             job->SetNextAggrTree(std::move(trees[random(engine)]));
         }
     }
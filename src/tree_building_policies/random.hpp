@@ -2,6 +2,7 @@
 
 #include "fat_tree_resource.hpp"
 #include "job.hpp"
+#include "simulation_context.hpp"
 #include <memory>
 #include <vector>
 
@@ -10,6 +11,7 @@ private:
     using AggrTree = typename FatTree::AggrTree;
 
 public:
+    // Chooses the tree of each new job with the tree building stream of the job.
     void operator()(const FatTreeResource &resources, const std::vector<std::unique_ptr<Job>> &jobs,
-                    const std::vector<Job *> &newJobs) const;
+                    const std::vector<Job *> &newJobs, SimulationContext &context) const;
 };
@@ -5,15 +5,16 @@
 
 void SmartTreeBuildingPolicy::operator()(const FatTreeResource &resources,
                                          const std::vector<std::unique_ptr<Job>> &jobs,
-                                         const std::vector<Job *> &) const {
+                                         const std::vector<Job *> &, SimulationContext &context) const {
     // Build aggregation tree for each job
     std::vector<FatTree::AggrTree> aggrTrees;
     std::vector<unsigned int> treeIdxToJobIdx;
+    auto round = context.TreeBuildingRound++;
     for (unsigned int jobIdx = 0; jobIdx < jobs.size(); ++jobIdx) {
         auto roots = resources.Topology->GetClosestCommonAncestors(jobs[jobIdx]->GetHosts());
         std::vector<const FatTree::Node *> chosenRoots;
         if (MaxTreeCount && *MaxTreeCount < roots.size()) {
-            thread_local std::default_random_engine engine(42);
+            auto engine = context.GetRandomEngine(RandomSubsystem::TreeBuilding, jobs[jobIdx]->ID, round);
             std::sample(roots.cbegin(), roots.cend(), std::back_inserter(chosenRoots), *MaxTreeCount, engine);
         } else
             chosenRoots = roots;
@@ -27,12 +28,15 @@ void SmartTreeBuildingPolicy::operator()(const FatTreeResource &resources,
     for (unsigned int i = 0; i < graph.NodeCount; ++i)
         graph.SetNodeWeight(i, jobs[treeIdxToJobIdx[i]]->HostCount);
     for (unsigned int i = 0; i < graph.NodeCount; ++i)
-        for (unsigned int j = 0; j < graph.NodeCount; ++j) {
-            if (i == j)
-                continue;
-            if (treeIdxToJobIdx[i] == treeIdxToJobIdx[j] || resources.CheckTreeConflict(aggrTrees[i], aggrTrees[j]))
+        for (unsigned int j = i + 1; j < graph.NodeCount && treeIdxToJobIdx[i] == treeIdxToJobIdx[j]; ++j)
+            graph.AddEdge(i, j);
+    auto treeIndex = resources.CreateAggrTreeIndex();
+    for (unsigned int i = 0; i < graph.NodeCount; ++i)
+        treeIndex.Register(i, aggrTrees[i]);
+    for (unsigned int i = 0; i < graph.NodeCount; ++i)
+        for (auto j : treeIndex.GetConflictingTrees(aggrTrees[i]))
+            if (j > i)
                 graph.AddEdge(i, j);
-        }
     // Find maximum independent set
     auto mis = graph.CalcMaxIndependentSet();
     // Find sharing opportunities
@@ -2,15 +2,17 @@
 
 #include "fat_tree_resource.hpp"
 #include "job.hpp"
+#include "simulation_context.hpp"
 #include <memory>
 #include <vector>
 
 class SmartTreeBuildingPolicy {
 public:
-    const std::optional<unsigned int> MaxTreeCount;
+    std::optional<unsigned int> MaxTreeCount;
 
     explicit SmartTreeBuildingPolicy(std::optional<unsigned int> maxTreeCount) : MaxTreeCount(maxTreeCount) {}
 
+    // Samples the roots of each job with its tree building stream in the round of the call.
     void operator()(const FatTreeResource &resources, const std::vector<std::unique_ptr<Job>> &jobs,
-                    const std::vector<Job *> &newJobs) const;
+                    const std::vector<Job *> &newJobs, SimulationContext &context) const;
 };
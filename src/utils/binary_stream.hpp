@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Writes values in the native byte order, for data that is read back by the same build.
+class BinaryWriter {
+private:
+    std::ostream &m_Stream;
+
+public:
+    explicit BinaryWriter(std::ostream &stream) : m_Stream(stream) {}
+
+    template <typename T>
+    void Write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        // Booleans are one byte of 0 or 1 whatever the size of bool
+        if constexpr (std::is_same_v<T, bool>)
+            Write<std::uint8_t>(value);
+        else
+            m_Stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    template <typename T>
+    void WriteVector(const std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Write<std::uint64_t>(values.size());
+        m_Stream.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    }
+    void WriteString(const std::string &str) {
+        Write<std::uint64_t>(str.size());
+        m_Stream.write(str.data(), str.size());
+    }
+    bool IsGood() const { return m_Stream.good(); }
+};
+
+// Reads what BinaryWriter writes, throws std::runtime_error if the stream ends early, if a boolean is neither 0 nor 1,
+// or if a length is more than what is left of the stream.
+class BinaryReader {
+private:
+    std::istream &m_Stream;
+    // The end of the stream if it is seekable, which lengths are checked against before anything is allocated
+    bool m_IsSeekable = false;
+    std::uint64_t m_EndPosition = 0;
+
+    void ReadBytes(char *data, std::size_t size) {
+        if (!m_Stream.read(data, size))
+            throw std::runtime_error("Unexpected end of binary data");
+    }
+    // Reads the length of a sequence of elements of the size.
+    std::uint64_t ReadLength(std::size_t elementSize) {
+        auto length = Read<std::uint64_t>();
+        if (m_IsSeekable) {
+            std::uint64_t position = m_Stream.tellg();
+            if (position > m_EndPosition || length > (m_EndPosition - position) / elementSize)
+                throw std::runtime_error("Length past the end of binary data");
+        }
+        return length;
+    }
+    // Reads the elements in chunks if the stream is not seekable, so that memory only grows with the data present.
+    template <typename TContainer>
+    void ReadElements(TContainer &elements, std::uint64_t length) {
+        constexpr std::uint64_t ElementSize = sizeof(typename TContainer::value_type);
+        constexpr std::uint64_t ChunkSize = std::max<std::uint64_t>((1 << 20) / ElementSize, 1);
+        auto chunkSize = m_IsSeekable ? length : ChunkSize;
+        for (std::uint64_t begin = 0; begin < length; begin += chunkSize) {
+            auto count = std::min(chunkSize, length - begin);
+            elements.resize(begin + count);
+            ReadBytes(reinterpret_cast<char *>(elements.data() + begin), count * ElementSize);
+        }
+    }
+
+public:
+    explicit BinaryReader(std::istream &stream) : m_Stream(stream) {
+        auto position = stream.tellg();
+        if (position == std::istream::pos_type(-1))
+            return;
+        if (stream.seekg(0, std::ios::end)) {
+            m_IsSeekable = true;
+            m_EndPosition = static_cast<std::uint64_t>(stream.tellg());
+            stream.seekg(position);
+        } else {
+            stream.clear();
+        }
+    }
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if constexpr (std::is_same_v<T, bool>) {
+            auto value = Read<std::uint8_t>();
+            if (value > 1)
+                throw std::runtime_error("Malformed boolean in binary data");
+            return value == 1;
+        } else {
+            T value;
+            ReadBytes(reinterpret_cast<char *>(&value), sizeof(value));
+            return value;
+        }
+    }
+    template <typename T>
+    std::vector<T> ReadVector() {
+        static_assert(std::is_trivially_copyable_v<T> && !std::is_same_v<T, bool>);
+        std::vector<T> values;
+        ReadElements(values, ReadLength(sizeof(T)));
+        return values;
+    }
+    std::string ReadString() {
+        std::string str;
+        ReadElements(str, ReadLength(1));
+        return str;
+    }
+};
@@ -0,0 +1,111 @@
+#include "id_span_kernels.hpp"
+#include <cassert>
+#if defined(__AVX2__) || defined(__AVX512F__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(unsigned int) == 4, "IDs and usage counters are assumed to be 32-bit");
+
+static bool IntersectScalar(const unsigned int *ids1, std::size_t count1, const unsigned int *ids2,
+                            std::size_t count2) {
+    std::size_t i = 0, j = 0;
+    while (i < count1 && j < count2) {
+        if (ids1[i] == ids2[j])
+            return true;
+        if (ids1[i] < ids2[j])
+            ++i;
+        else
+            ++j;
+    }
+    return false;
+}
+
+bool IdSpanKernels::Intersect(const unsigned int *ids1, std::size_t count1, const unsigned int *ids2,
+                              std::size_t count2) {
+    std::size_t i = 0, j = 0;
+#if defined(__AVX2__)
+    // Compare a block of 8 IDs with all rotations of the other block, then skip the block with the smaller maximum
+    const auto rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    while (i + 8 <= count1 && j + 8 <= count2) {
+        auto block1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ids1 + i));
+        auto block2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ids2 + j));
+        auto equal = _mm256_cmpeq_epi32(block1, block2);
+        for (unsigned int r = 1; r < 8; ++r) {
+            block2 = _mm256_permutevar8x32_epi32(block2, rotate);
+            equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(block1, block2));
+        }
+        if (!_mm256_testz_si256(equal, equal))
+            return true;
+        auto max1 = ids1[i + 7], max2 = ids2[j + 7];
+        i += max1 <= max2 ? 8 : 0;
+        j += max2 <= max1 ? 8 : 0;
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    // The same with blocks of 4 IDs
+    while (i + 4 <= count1 && j + 4 <= count2) {
+        auto block1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ids1 + i));
+        auto block2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ids2 + j));
+        auto equal = _mm_cmpeq_epi32(block1, block2);
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(block1, _mm_shuffle_epi32(block2, _MM_SHUFFLE(0, 3, 2, 1))));
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(block1, _mm_shuffle_epi32(block2, _MM_SHUFFLE(1, 0, 3, 2))));
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(block1, _mm_shuffle_epi32(block2, _MM_SHUFFLE(2, 1, 0, 3))));
+        if (_mm_movemask_epi8(equal) != 0)
+            return true;
+        auto max1 = ids1[i + 3], max2 = ids2[j + 3];
+        i += max1 <= max2 ? 4 : 0;
+        j += max2 <= max1 ? 4 : 0;
+    }
+#endif
+    return IntersectScalar(ids1 + i, count1 - i, ids2 + j, count2 - j);
+}
+
+bool IdSpanKernels::AnyReachesQuota(const unsigned int *counters, const unsigned int *ids, std::size_t count,
+                                    unsigned int quota) {
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    // counter >= quota if and only if max(counter, quota) == counter
+    const auto quotas = _mm256_set1_epi32(static_cast<int>(quota));
+    for (; i + 8 <= count; i += 8) {
+        auto indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ids + i));
+        auto values = _mm256_i32gather_epi32(reinterpret_cast<const int *>(counters), indices, 4);
+        auto reached = _mm256_cmpeq_epi32(_mm256_max_epu32(values, quotas), values);
+        if (!_mm256_testz_si256(reached, reached))
+            return true;
+    }
+#endif
+    for (; i < count; ++i)
+        if (counters[ids[i]] >= quota)
+            return true;
+    return false;
+}
+
+void IdSpanKernels::Increment(unsigned int *counters, const unsigned int *ids, std::size_t count) {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    // Scatter is safe since the IDs are distinct
+    const auto ones = _mm512_set1_epi32(1);
+    for (; i + 16 <= count; i += 16) {
+        auto indices = _mm512_loadu_si512(ids + i);
+        auto values = _mm512_i32gather_epi32(indices, counters, 4);
+        _mm512_i32scatter_epi32(counters, indices, _mm512_add_epi32(values, ones), 4);
+    }
+#endif
+    for (; i < count; ++i)
+        ++counters[ids[i]];
+}
+
+void IdSpanKernels::Decrement(unsigned int *counters, const unsigned int *ids, std::size_t count) {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    const auto ones = _mm512_set1_epi32(1);
+    for (; i + 16 <= count; i += 16) {
+        auto indices = _mm512_loadu_si512(ids + i);
+        auto values = _mm512_i32gather_epi32(indices, counters, 4);
+        _mm512_i32scatter_epi32(counters, indices, _mm512_sub_epi32(values, ones), 4);
+    }
+#endif
+    for (; i < count; ++i) {
+        assert(counters[ids[i]] > 0);
+        --counters[ids[i]];
+    }
+}
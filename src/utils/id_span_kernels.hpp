@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// Kernels over spans of 32-bit IDs. They use AVX-512, AVX2 or SSE2 when the compiler targets them, and
+// fall back to scalar code otherwise.
+class IdSpanKernels {
+public:
+    // Returns whether the two sorted spans have an ID in common.
+    static bool Intersect(const unsigned int *ids1, std::size_t count1, const unsigned int *ids2, std::size_t count2);
+    // Returns whether counters[id] >= quota for any ID in the span.
+    static bool AnyReachesQuota(const unsigned int *counters, const unsigned int *ids, std::size_t count,
+                                unsigned int quota);
+    // Increments or decrements counters[id] for each ID in the span, the IDs must be distinct.
+    static void Increment(unsigned int *counters, const unsigned int *ids, std::size_t count);
+    static void Decrement(unsigned int *counters, const unsigned int *ids, std::size_t count);
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// A binary min-heap whose elements are addressed by dense handles, so that the key of any element can be changed
+// (increased or decreased) or the element can be removed in O(log n).
+template <typename TKey, typename TCompare = std::less<TKey>>
+class IndexedHeap {
+private:
+    static constexpr unsigned int NotInHeap = std::numeric_limits<unsigned int>::max();
+
+    std::vector<std::pair<TKey, unsigned int>> m_Heap; // Pairs of key and handle
+    std::vector<unsigned int> m_Positions;             // Position of each handle in m_Heap
+    TCompare m_Compare;
+
+    bool Less(unsigned int pos1, unsigned int pos2) const { return m_Compare(m_Heap[pos1].first, m_Heap[pos2].first); }
+
+    void Swap(unsigned int pos1, unsigned int pos2) {
+        std::swap(m_Heap[pos1], m_Heap[pos2]);
+        m_Positions[m_Heap[pos1].second] = pos1;
+        m_Positions[m_Heap[pos2].second] = pos2;
+    }
+
+    void SiftUp(unsigned int pos) {
+        while (pos > 0) {
+            auto parent = (pos - 1) / 2;
+            if (!Less(pos, parent))
+                break;
+            Swap(pos, parent);
+            pos = parent;
+        }
+    }
+
+    void SiftDown(unsigned int pos) {
+        while (true) {
+            auto smallest = pos, left = pos * 2 + 1, right = pos * 2 + 2;
+            if (left < m_Heap.size() && Less(left, smallest))
+                smallest = left;
+            if (right < m_Heap.size() && Less(right, smallest))
+                smallest = right;
+            if (smallest == pos)
+                break;
+            Swap(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+public:
+    bool Empty() const { return m_Heap.empty(); }
+    unsigned int Size() const { return m_Heap.size(); }
+    bool Contains(unsigned int handle) const { return handle < m_Positions.size() && m_Positions[handle] != NotInHeap; }
+
+    const TKey &GetKey(unsigned int handle) const {
+        assert(Contains(handle));
+        return m_Heap[m_Positions[handle]].first;
+    }
+    const TKey &TopKey() const {
+        assert(!Empty());
+        return m_Heap.front().first;
+    }
+    unsigned int TopHandle() const {
+        assert(!Empty());
+        return m_Heap.front().second;
+    }
+
+    void Push(unsigned int handle, const TKey &key) {
+        assert(!Contains(handle));
+        if (handle >= m_Positions.size())
+            m_Positions.resize(handle + 1, NotInHeap);
+        m_Positions[handle] = m_Heap.size();
+        m_Heap.emplace_back(key, handle);
+        SiftUp(m_Heap.size() - 1);
+    }
+
+    void Update(unsigned int handle, const TKey &key) {
+        assert(Contains(handle));
+        auto pos = m_Positions[handle];
+        bool decreased = m_Compare(key, m_Heap[pos].first);
+        m_Heap[pos].first = key;
+        if (decreased)
+            SiftUp(pos);
+        else
+            SiftDown(pos);
+    }
+
+    void PushOrUpdate(unsigned int handle, const TKey &key) {
+        if (Contains(handle))
+            Update(handle, key);
+        else
+            Push(handle, key);
+    }
+
+    void Erase(unsigned int handle) {
+        assert(Contains(handle));
+        auto pos = m_Positions[handle];
+        auto last = m_Heap.size() - 1;
+        if (pos != last) {
+            Swap(pos, last);
+            m_Heap.pop_back();
+            m_Positions[handle] = NotInHeap;
+            SiftDown(pos);
+            SiftUp(pos);
+        } else {
+            m_Heap.pop_back();
+            m_Positions[handle] = NotInHeap;
+        }
+    }
+
+    unsigned int Pop() {
+        auto handle = TopHandle();
+        Erase(handle);
+        return handle;
+    }
+
+    void Clear() {
+        m_Heap.clear();
+        m_Positions.clear();
+    }
+};
@@ -0,0 +1,46 @@
+#include "mapped_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *path) {
+    auto fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        auto data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            m_Data = static_cast<const std::byte *>(data);
+            m_Size = fileStat.st_size;
+            m_IsMapped = true;
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (m_IsMapped)
+        munmap(const_cast<std::byte *>(m_Data), m_Size);
+}
+#else
+#include <fstream>
+#include <iterator>
+
+MappedFile::MappedFile(const char *path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return;
+    for (auto iter = std::istreambuf_iterator<char>(file); iter != std::istreambuf_iterator<char>(); ++iter)
+        m_Buffer.push_back(static_cast<std::byte>(*iter));
+    if (m_Buffer.empty())
+        return;
+    m_Data = m_Buffer.data();
+    m_Size = m_Buffer.size();
+}
+
+MappedFile::~MappedFile() = default;
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// A read-only view of a whole file. The file is memory-mapped where supported, so that processes and simulations
+// reading the same file share its pages, and read into a buffer elsewhere.
+class MappedFile {
+private:
+    const std::byte *m_Data = nullptr;
+    std::size_t m_Size = 0;
+    bool m_IsMapped = false;
+    std::vector<std::byte> m_Buffer;
+
+public:
+    explicit MappedFile(const char *path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Returns whether the file is read, which fails for an empty file as well.
+    bool IsOpen() const { return m_Data != nullptr; }
+    const std::byte *GetData() const { return m_Data; }
+    std::size_t GetSize() const { return m_Size; }
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// The Philox4x32-10 generator of Salmon et al., "Parallel random numbers: as easy as 1, 2, 3". Each block of 4 outputs
+// is a bijection of a 128-bit counter under a 64-bit key, so the streams of different keys are independent and any
+// draw of a stream is computed directly from its position. Meets UniformRandomBitGenerator, so it works with the
+// distributions and algorithms of <random> and <algorithm>.
+//
+// The upper half of the counter selects the stream under the key and the lower half counts the blocks drawn from it.
+class PhiloxEngine {
+public:
+    using result_type = std::uint32_t;
+    using Block = std::array<std::uint32_t, 4>;
+
+private:
+    std::array<std::uint32_t, 2> m_Key;
+    std::uint64_t m_Stream;
+    std::uint64_t m_BlockIdx = 0;
+    Block m_Block;
+    unsigned int m_OutputIdx = 4; // Next output of m_Block, which is computed when needed
+
+    static constexpr void MulHiLo(std::uint32_t a, std::uint32_t b, std::uint32_t &hi, std::uint32_t &lo) {
+        auto product = static_cast<std::uint64_t>(a) * b;
+        hi = static_cast<std::uint32_t>(product >> 32);
+        lo = static_cast<std::uint32_t>(product);
+    }
+
+public:
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    PhiloxEngine(std::uint64_t key, std::uint64_t stream)
+        : m_Key{static_cast<std::uint32_t>(key), static_cast<std::uint32_t>(key >> 32)}, m_Stream(stream) {}
+
+    // Returns the block at the counter under the key.
+    static constexpr Block Generate(Block counter, std::array<std::uint32_t, 2> key) {
+        for (unsigned int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += 0x9E3779B9;
+                key[1] += 0xBB67AE85;
+            }
+            std::uint32_t hi0 = 0, lo0 = 0, hi1 = 0, lo1 = 0;
+            MulHiLo(0xD2511F53, counter[0], hi0, lo0);
+            MulHiLo(0xCD9E8D57, counter[2], hi1, lo1);
+            counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+        }
+        return counter;
+    }
+
+    result_type operator()() {
+        if (m_OutputIdx == 4) {
+            m_Block = Generate({static_cast<std::uint32_t>(m_BlockIdx), static_cast<std::uint32_t>(m_BlockIdx >> 32),
+                                static_cast<std::uint32_t>(m_Stream), static_cast<std::uint32_t>(m_Stream >> 32)},
+                               m_Key);
+            ++m_BlockIdx;
+            m_OutputIdx = 0;
+        }
+        return m_Block[m_OutputIdx++];
+    }
+
+    // Skips the outputs in O(1).
+    void discard(unsigned long long count) {
+        // m_BlockIdx is past m_Block once it is computed
+        auto position = (m_OutputIdx == 4 ? m_BlockIdx * 4 : (m_BlockIdx - 1) * 4 + m_OutputIdx) + count;
+        m_BlockIdx = position / 4;
+        m_OutputIdx = 4;
+        for (unsigned int i = 0; i < position % 4; ++i)
+            (*this)();
+    }
+};
+
+// Returns whether Generate gives the expected block, which std::array cannot compare at compile time in C++17.
+constexpr bool IsPhiloxKnownAnswer(PhiloxEngine::Block counter, std::array<std::uint32_t, 2> key,
+                                   PhiloxEngine::Block expected) {
+    auto block = PhiloxEngine::Generate(counter, key);
+    for (unsigned int i = 0; i < block.size(); ++i)
+        if (block[i] != expected[i])
+            return false;
+    return true;
+}
+
+// The known-answer tests of Random123 for Philox4x32-10, checked at compile time so that any change to Generate that
+// alters the streams fails the build.
+static_assert(IsPhiloxKnownAnswer({0, 0, 0, 0}, {0, 0}, {0x6627E8D5, 0xE169C58D, 0xBC57AC4C, 0x9B00DBD8}));
+static_assert(IsPhiloxKnownAnswer({0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF}, {0xFFFFFFFF, 0xFFFFFFFF},
+                                  {0x408F276D, 0x41C83B0E, 0xA20BC7C6, 0x6D5451FD}));
+static_assert(IsPhiloxKnownAnswer({0x243F6A88, 0x85A308D3, 0x13198A2E, 0x03707344}, {0xA4093822, 0x299F31D0},
+                                  {0xD16CFE09, 0x94FDCCEB, 0x5001E420, 0x24126EA1}));
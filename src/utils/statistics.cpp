@@ -0,0 +1,65 @@
+#include "statistics.hpp"
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+double CalcTCriticalValue(unsigned int degreesOfFreedom, double confidence) {
+    assert(degreesOfFreedom > 0 && confidence > 0.0 && confidence < 1.0);
+    // Bisection on the integral of the density from 0, by Simpson's rule
+    double nu = degreesOfFreedom;
+    auto logScale = std::lgamma((nu + 1) / 2) - std::lgamma(nu / 2) - std::log(nu * std::acos(-1.0)) / 2;
+    auto density = [nu, logScale](double t) { return std::exp(logScale - (nu + 1) / 2 * std::log1p(t * t / nu)); };
+    auto probability = [&density](double x) {
+        const unsigned int intervalCount = 2000;
+        auto step = x / intervalCount;
+        auto sum = density(0.0) + density(x);
+        for (unsigned int i = 1; i < intervalCount; ++i)
+            sum += (i % 2 ? 4 : 2) * density(i * step);
+        return sum * step / 3;
+    };
+    double low = 0.0, high = 1.0;
+    while (probability(high) < confidence / 2)
+        high *= 2;
+    for (unsigned int i = 0; i < 60; ++i) {
+        auto middle = (low + high) / 2;
+        (probability(middle) < confidence / 2 ? low : high) = middle;
+    }
+    return (low + high) / 2;
+}
+
+Interval CalcInterval(const std::vector<double> &values, double confidence) {
+    auto count = values.size();
+    auto mean = std::accumulate(values.cbegin(), values.cend(), 0.0) / count;
+    if (count < 2)
+        return {mean, std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN()};
+    double sumOfSquares = 0.0;
+    for (auto value : values)
+        sumOfSquares += (value - mean) * (value - mean);
+    auto stdDev = std::sqrt(sumOfSquares / (count - 1));
+    return {mean, stdDev, CalcTCriticalValue(count - 1, confidence) * stdDev / std::sqrt(count)};
+}
+
+unsigned int CalcMserTruncation(const std::vector<double> &values) {
+    auto count = static_cast<unsigned int>(values.size());
+    // Sums of the values from each position to the end, taken about the overall mean for accuracy
+    auto mean = std::accumulate(values.cbegin(), values.cend(), 0.0) / count;
+    double sum = 0.0, sumOfSquares = 0.0;
+    unsigned int bestTruncation = count / 2;
+    auto bestStatistic = std::numeric_limits<double>::infinity();
+    for (auto truncation = count; truncation-- > 0;) {
+        auto deviation = values[truncation] - mean;
+        sum += deviation;
+        sumOfSquares += deviation * deviation;
+        if (truncation > count / 2)
+            continue;
+        double keptCount = count - truncation;
+        auto statistic = (sumOfSquares - sum * sum / keptCount) / (keptCount * keptCount);
+        // Ties go to the shorter truncation
+        if (statistic <= bestStatistic) {
+            bestStatistic = statistic;
+            bestTruncation = truncation;
+        }
+    }
+    return bestTruncation;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+// Returns x such that P(-x <= T <= x) is the confidence for Student's t distribution with the degrees of freedom.
+double CalcTCriticalValue(unsigned int degreesOfFreedom, double confidence);
+
+struct Interval {
+    double Mean;
+    double StdDev;
+    double HalfWidth; // NaN with fewer than 2 values
+};
+
+// Returns the mean and the two-sided Student t interval of values taken as independent.
+Interval CalcInterval(const std::vector<double> &values, double confidence);
+
+// Returns the number of leading values to drop as the initial transient by the MSER rule of White, which minimizes the
+// squared standard error of the mean of the rest. Only the first half is considered, so a result of values.size() / 2
+// means the transient may not be over yet.
+unsigned int CalcMserTruncation(const std::vector<double> &values);
@@ -0,0 +1,101 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cassert>
+
+ThreadPool::ThreadPool(unsigned int workerCount) {
+    assert(workerCount > 0);
+    for (unsigned int i = 0; i < workerCount; ++i)
+        m_Queues.push_back(std::make_unique<Queue>());
+    for (unsigned int i = 1; i < workerCount; ++i)
+        m_Threads.emplace_back(&ThreadPool::RunWorker, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_WorkAvailable.notify_all();
+    for (auto &thread : m_Threads)
+        thread.join();
+}
+
+std::optional<ThreadPool::Range> ThreadPool::PopRange(unsigned int worker) {
+    {
+        auto &queue = *m_Queues[worker];
+        std::lock_guard lock(queue.Mutex);
+        if (!queue.Ranges.empty()) {
+            auto range = queue.Ranges.front();
+            queue.Ranges.pop_front();
+            return range;
+        }
+    }
+    for (unsigned int i = 1; i < m_Queues.size(); ++i) {
+        auto &queue = *m_Queues[(worker + i) % m_Queues.size()];
+        std::lock_guard lock(queue.Mutex);
+        if (!queue.Ranges.empty()) {
+            auto range = queue.Ranges.back();
+            queue.Ranges.pop_back();
+            return range;
+        }
+    }
+    return std::nullopt;
+}
+
+void ThreadPool::RunRanges(unsigned int worker) {
+    while (auto range = PopRange(worker)) {
+        for (auto i = range->Begin; i < range->End; ++i)
+            (*m_Func)(i);
+        if (--m_PendingRangeCount == 0) {
+            std::lock_guard lock(m_Mutex);
+            m_WorkDone.notify_all();
+        }
+    }
+}
+
+void ThreadPool::RunWorker(unsigned int worker) {
+    unsigned int generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(m_Mutex);
+            m_WorkAvailable.wait(lock, [this, generation] { return m_Stopping || m_Generation != generation; });
+            if (m_Stopping)
+                return;
+            generation = m_Generation;
+        }
+        RunRanges(worker);
+    }
+}
+
+void ThreadPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)> &func,
+                             unsigned int maxRangeSize) {
+    if (count == 0)
+        return;
+    if (m_Queues.size() == 1) {
+        for (unsigned int i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+    // A few ranges per worker, so that uneven iterations can be balanced by stealing
+    auto rangeSize = std::clamp(count / (GetWorkerCount() * 4), 1u, std::max(1u, maxRangeSize));
+    m_PendingRangeCount = (count + rangeSize - 1) / rangeSize;
+    // The function is set before any range is visible to the workers
+    m_Func = &func;
+    unsigned int worker = 0;
+    for (unsigned int begin = 0; begin < count; begin += rangeSize) {
+        auto &queue = *m_Queues[worker];
+        {
+            std::lock_guard lock(queue.Mutex);
+            queue.Ranges.push_back({begin, std::min(begin + rangeSize, count)});
+        }
+        worker = (worker + 1) % m_Queues.size();
+    }
+    {
+        std::lock_guard lock(m_Mutex);
+        ++m_Generation;
+    }
+    m_WorkAvailable.notify_all();
+    RunRanges(0);
+    std::unique_lock lock(m_Mutex);
+    m_WorkDone.wait(lock, [this] { return m_PendingRangeCount == 0; });
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// A fixed pool of worker threads for data-parallel loops. The iterations of a loop are split into ranges that are
+// dealt to per-worker queues, and a worker that runs out of ranges steals from the back of the other queues.
+class ThreadPool {
+private:
+    struct Range {
+        unsigned int Begin, End;
+    };
+    struct Queue {
+        std::mutex Mutex;
+        std::deque<Range> Ranges;
+    };
+
+    std::vector<std::thread> m_Threads;
+    std::vector<std::unique_ptr<Queue>> m_Queues; // One per worker, the calling thread is worker 0
+    const std::function<void(unsigned int)> *m_Func = nullptr;
+    std::atomic<unsigned int> m_PendingRangeCount = 0;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkAvailable, m_WorkDone;
+    unsigned int m_Generation = 0;
+    bool m_Stopping = false;
+
+    std::optional<Range> PopRange(unsigned int worker);
+    void RunRanges(unsigned int worker);
+    void RunWorker(unsigned int worker);
+
+public:
+    explicit ThreadPool(unsigned int workerCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned int GetWorkerCount() const { return m_Queues.size(); }
+
+    // Calls func(i) for every i in [0, count) on the workers including the calling thread, and returns when all of
+    // them are done. Iterations are dealt in ranges of at most maxRangeSize, which is 1 for iterations that are few and
+    // long and vary in length, e.g. whole simulations, so that no iteration waits behind a slow one.
+    void ParallelFor(unsigned int count, const std::function<void(unsigned int)> &func,
+                     unsigned int maxRangeSize = std::numeric_limits<unsigned int>::max());
+};
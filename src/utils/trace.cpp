@@ -1,95 +1,152 @@
 #include "trace.hpp"
 #include "job.hpp"
-#include <fstream>
-#include <nlohmann/json.hpp>
-
-std::string Tracer::GetEventNameFromJob(const Job &job, bool includeStep, bool includeGroup, bool includeCommOp,
-                                        bool includeTransmission, bool includeWaiting) const {
-    std::string name = "Job #" + std::to_string(job.ID);
-    if (includeStep)
-        name += " Step #" + std::to_string(job.GetCurrentStepIdx());
-    if (includeGroup)
-        name += " Group #" + std::to_string(job.GetCurrentGroupIdx());
-    if (includeCommOp)
-        name += " CommOp #" + std::to_string(job.GetCurrentOpIdx());
-    if (includeTransmission)
-        name += (job.IsUsingSharp() ? " Transmission(SHARP, " : " Transmission(Non-SHARP, ") +
-                std::to_string(job.GetCurrentOpTransmittedMessageSize()) + "B~" +
-                std::to_string(job.GetCurrentOpTransmittedMessageSize() + job.GetTransmittingMessageSize()) + "B)";
-    if (includeWaiting)
-        name += " Waiting";
-    return name;
-}
-
-Tracer::~Tracer() {
-    if (!EnableRecording)
-        return;
-    std::ofstream file("trace.json");
-    file << m_RecordedTraces.dump();
-}
-
-void Tracer::RecordEvent(std::string &&name, const char *category, bool isBegin, unsigned int pid, unsigned int tid,
-                         double time) {
-    if (!EnableRecording)
-        return;
-    m_RecordedTraces.push_back({
-        {"name", name},
-        {"cat", category},
-        {"ph", isBegin ? "B" : "E"},
-        {"pid", pid},
-        {"tid", tid},
-        {"ts", time * 1'000'000},
-    });
-}
-
-void Tracer::RecordBeginJob(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job), "Job", true, 0, job.ID, time);
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+static const char *GetEventCategory(const TraceEvent &event) {
+    switch (event.EventKind) {
+    case TraceEvent::Kind::Job:
+        return "Job";
+    case TraceEvent::Kind::Step:
+        return "Step";
+    case TraceEvent::Kind::Group:
+        return "Group";
+    case TraceEvent::Kind::CommOp:
+        return "CommOp";
+    case TraceEvent::Kind::Transmission:
+        return event.UseSharp ? "Transmission,SHARP" : "Transmission,NonSHARP";
+    case TraceEvent::Kind::Waiting:
+        return "Waiting";
+    }
+    return "";
 }
 
-void Tracer::RecordEndJob(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job), "Job", false, 0, job.ID, time);
+// Formats the name of the event, e.g. "Job #1 Step #2 Group #0 CommOp #3", into the buffer and returns its length.
+static int FormatEventName(const TraceEvent &event, char *buffer, std::size_t size) {
+    switch (event.EventKind) {
+    case TraceEvent::Kind::Job:
+        return std::snprintf(buffer, size, "Job #%u", event.JobID);
+    case TraceEvent::Kind::Step:
+        return std::snprintf(buffer, size, "Job #%u Step #%u", event.JobID, event.StepIdx);
+    case TraceEvent::Kind::Group:
+        return std::snprintf(buffer, size, "Job #%u Step #%u Group #%u", event.JobID, event.StepIdx, event.GroupIdx);
+    case TraceEvent::Kind::CommOp:
+        return std::snprintf(buffer, size, "Job #%u Step #%u Group #%u CommOp #%u", event.JobID, event.StepIdx,
+                             event.GroupIdx, event.OpIdx);
+    case TraceEvent::Kind::Transmission:
+        return std::snprintf(buffer, size, "Job #%u Step #%u Group #%u CommOp #%u Transmission(%s, %lluB~%lluB)",
+                             event.JobID, event.StepIdx, event.GroupIdx, event.OpIdx,
+                             event.UseSharp ? "SHARP" : "Non-SHARP",
+                             static_cast<unsigned long long>(event.MessageBegin),
+                             static_cast<unsigned long long>(event.MessageEnd));
+    case TraceEvent::Kind::Waiting:
+        return std::snprintf(buffer, size, "Job #%u Step #%u Group #%u CommOp #%u Waiting", event.JobID,
+                             event.StepIdx, event.GroupIdx, event.OpIdx);
+    }
+    return 0;
 }
 
-void Tracer::RecordBeginStep(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true), "Step", true, 0, job.ID, time);
+Tracer::Tracer(const std::string &path, TraceFilter filter, std::size_t bufferSize, unsigned int bufferCount)
+    : m_Filter(std::move(filter)), m_File(path), m_BufferSize(bufferSize), m_Buffers(bufferCount) {
+    assert(bufferSize > 0 && bufferCount >= 2);
+    assert(std::is_sorted(m_Filter.JobIDs.cbegin(), m_Filter.JobIDs.cend()));
+    for (auto &buffer : m_Buffers)
+        buffer.Events = std::make_unique<TraceEvent[]>(bufferSize);
+    m_File << '[';
+    m_File.flush();
+    m_Writer = std::thread(&Tracer::RunWriter, this);
 }
 
-void Tracer::RecordEndStep(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true), "Step", false, 0, job.ID, time);
-}
-
-void Tracer::RecordBeginGroup(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true, true), "Group", true, 0, job.ID, time);
-}
-
-void Tracer::RecordEndGroup(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true, true), "Group", false, 0, job.ID, time);
-}
-
-void Tracer::RecordBeginCommOp(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true, true, true), "CommOp", true, 0, job.ID, time);
+Tracer::~Tracer() {
+    if (m_Buffers[m_CurrentBufferIdx].Size > 0)
+        SubmitBuffer();
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_BufferFilled.notify_one();
+    m_Writer.join();
+    m_File << "\n]\n";
 }
 
-void Tracer::RecordEndCommOp(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true, true, true), "CommOp", false, 0, job.ID, time);
+void Tracer::SubmitBuffer() {
+    std::unique_lock lock(m_Mutex);
+    ++m_FilledBufferCount;
+    m_BufferFilled.notify_one();
+    m_BufferWritten.wait(lock, [this] { return m_FilledBufferCount < m_Buffers.size(); });
+    m_CurrentBufferIdx = (m_CurrentBufferIdx + 1) % m_Buffers.size();
+    m_Buffers[m_CurrentBufferIdx].Size = 0;
 }
 
-void Tracer::RecordBeginTransmission(double time, const Job &job) {
-    auto category = job.IsUsingSharp() ? "Transmission,SHARP" : "Transmission,NonSHARP";
-    RecordEvent(GetEventNameFromJob(job, true, true, true, true), category, true, 0, job.ID, time);
+void Tracer::RunWriter() {
+    while (true) {
+        {
+            std::unique_lock lock(m_Mutex);
+            m_BufferFilled.wait(lock, [this] { return m_Stopping || m_FilledBufferCount > 0; });
+            if (m_FilledBufferCount == 0)
+                return;
+        }
+        // The filled buffers are not touched by the recording thread until they are counted as written
+        WriteEvents(m_Buffers[m_WritingBufferIdx]);
+        m_WritingBufferIdx = (m_WritingBufferIdx + 1) % m_Buffers.size();
+        {
+            std::lock_guard lock(m_Mutex);
+            --m_FilledBufferCount;
+        }
+        m_BufferWritten.notify_one();
+    }
 }
 
-void Tracer::RecordEndTransmission(double time, const Job &job) {
-    auto category = job.IsUsingSharp() ? "Transmission,SHARP" : "Transmission,NonSHARP";
-    RecordEvent(GetEventNameFromJob(job, true, true, true, true), category, false, 0, job.ID, time);
+void Tracer::WriteEvents(const Buffer &buffer) {
+    std::string text;
+    char name[256];
+    char line[512];
+    for (std::size_t i = 0; i < buffer.Size; ++i) {
+        const auto &event = buffer.Events[i];
+        FormatEventName(event, name, sizeof(name));
+        // Events are separated before rather than after, so that the file never ends with a dangling comma
+        auto length = std::snprintf(line, sizeof(line),
+                                    "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\","
+                                    "\"pid\":0,\"tid\":%u,\"ts\":%.3f}",
+                                    m_IsFirstEvent ? "" : ",", name, GetEventCategory(event),
+                                    event.IsBegin ? "B" : "E", event.JobID, event.Time * 1'000'000);
+        assert(length > 0 && static_cast<std::size_t>(length) < sizeof(line));
+        text.append(line, length);
+        m_IsFirstEvent = false;
+    }
+    m_File.write(text.data(), text.size());
+    m_File.flush();
 }
 
-void Tracer::RecordBeginWaiting(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true, true, true, false, true), "Waiting", true, 0, job.ID, time);
+bool Tracer::IsJobTraced(unsigned int jobID, std::size_t groupJobCount) const {
+    if (m_Filter.SharedGroupsOnly && groupJobCount < 2)
+        return false;
+    if (!m_Filter.JobIDs.empty() && !std::binary_search(m_Filter.JobIDs.cbegin(), m_Filter.JobIDs.cend(), jobID))
+        return false;
+    if (m_Filter.JobSamplingRate >= 1.0)
+        return true;
+    // SplitMix64, which spreads consecutive IDs over the whole range
+    std::uint64_t hash = jobID + 0x9e3779b97f4a7c15ull;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return (hash >> 11) * 0x1p-53 < m_Filter.JobSamplingRate;
 }
 
-void Tracer::RecordEndWaiting(double time, const Job &job) {
-    RecordEvent(GetEventNameFromJob(job, true, true, true, false, true), "Waiting", false, 0, job.ID, time);
+void Tracer::Record(TraceEvent::Kind kind, bool isBegin, double time, const Job &job) {
+    if (m_Buffers[m_CurrentBufferIdx].Size == m_BufferSize)
+        SubmitBuffer();
+    auto &buffer = m_Buffers[m_CurrentBufferIdx];
+    auto &event = buffer.Events[buffer.Size++];
+    event.Time = time;
+    event.MessageBegin = job.GetCurrentOpTransmittedMessageSize();
+    event.MessageEnd = event.MessageBegin + job.GetTransmittingMessageSize();
+    event.JobID = job.ID;
+    event.StepIdx = job.GetCurrentStepIdx();
+    event.GroupIdx = job.GetCurrentGroupIdx();
+    event.OpIdx = job.GetCurrentOpIdx();
+    event.EventKind = kind;
+    event.IsBegin = isBegin;
+    event.UseSharp = job.IsUsingSharp();
 }
-
-Tracer Trace;
@@ -1,38 +1,112 @@
 #pragma once
 
-#include <nlohmann/json.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 class Job;
 
+// What a job does at the time of a trace event, with no names formatted so that recording is a few stores.
+struct TraceEvent {
+    enum class Kind : std::uint8_t { Job, Step, Group, CommOp, Transmission, Waiting };
+
+    double Time;
+    // The byte range of the CommOp being transmitted, only for transmissions
+    std::uint64_t MessageBegin;
+    std::uint64_t MessageEnd;
+    std::uint32_t JobID;
+    std::uint32_t StepIdx;
+    std::uint32_t GroupIdx;
+    std::uint32_t OpIdx;
+    Kind EventKind;
+    bool IsBegin;
+    bool UseSharp;
+};
+
+// Which events a tracer records. Jobs are chosen when they are put into a sharing group, and events by their kind and
+// time before anything is stored, so that a narrow filter costs little more than no tracer. Since events are dropped
+// one by one, spans crossing the edges of the filter have only their begin or end recorded.
+struct TraceFilter {
+    static constexpr unsigned int AllKinds = (1u << (static_cast<unsigned int>(TraceEvent::Kind::Waiting) + 1)) - 1;
+
+    // The window of simulated time in seconds
+    double StartTime = 0.0;
+    double EndTime = std::numeric_limits<double>::infinity();
+    // The IDs of the jobs to record, every job if empty
+    std::vector<unsigned int> JobIDs;
+    // The fraction of jobs to record, chosen by a hash of their IDs so that every run chooses the same jobs
+    double JobSamplingRate = 1.0;
+    // The kinds of events to record, with the bit of each kind given by GetKindBit
+    unsigned int KindMask = AllKinds;
+    // Whether to record the jobs only while they are in a sharing group with other jobs
+    bool SharedGroupsOnly = false;
+
+    static constexpr unsigned int GetKindBit(TraceEvent::Kind kind) { return 1u << static_cast<unsigned int>(kind); }
+};
+
+// Streams the events of one simulation to a file in the Chrome Trace Event format. Events are stored as TraceEvents
+// into a ring of fixed-size buffers, and a background thread formats each filled buffer into the file, so that memory
+// stays bounded however long the simulation is. Only whole events reach the file, and the closing bracket is optional
+// in the format, so the file is valid even if the simulation is killed. Events must be recorded by one thread at a
+// time.
 class Tracer {
 private:
-    nlohmann::json m_RecordedTraces;
+    struct Buffer {
+        std::unique_ptr<TraceEvent[]> Events;
+        std::size_t Size = 0;
+    };
+
+    const TraceFilter m_Filter;
+    std::ofstream m_File;
+    const std::size_t m_BufferSize;
+    std::vector<Buffer> m_Buffers;
+    unsigned int m_CurrentBufferIdx = 0; // The buffer being filled, owned by the recording thread
+    unsigned int m_WritingBufferIdx = 0; // The oldest filled buffer, owned by the writer thread
+    bool m_IsFirstEvent = true;          // Owned by the writer thread
 
-    std::string GetEventNameFromJob(const Job &job, bool includeStep = false, bool includeGroup = false,
-                                    bool includeCommOp = false, bool includeTransmission = false,
-                                    bool includeWaiting = false) const;
+    std::mutex m_Mutex;
+    std::condition_variable m_BufferFilled;
+    std::condition_variable m_BufferWritten;
+    unsigned int m_FilledBufferCount = 0;
+    bool m_Stopping = false;
+    std::thread m_Writer;
+
+    // Hands the current buffer over to the writer thread, and waits until the next one is written if it is not yet.
+    void SubmitBuffer();
+    void RunWriter();
+    void WriteEvents(const Buffer &buffer);
 
 public:
-    bool EnableRecording = false;
+    // Whether tracing is compiled in, which is turned off by defining DISABLE_TRACING. If not, jobs never record
+    // events and the checks for a tracer are removed at compile time.
+#ifdef DISABLE_TRACING
+    static constexpr bool IsEnabled = false;
+#else
+    static constexpr bool IsEnabled = true;
+#endif
 
+    // Creates the file at the path, using bufferCount buffers of bufferSize events.
+    explicit Tracer(const std::string &path, TraceFilter filter = {}, std::size_t bufferSize = 4096,
+                    unsigned int bufferCount = 4);
     ~Tracer();
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
 
-    void RecordEvent(std::string &&name, const char *category, bool isBegin, unsigned int pid, unsigned int tid,
-                     double time);
-
-    void RecordBeginJob(double time, const Job &job);
-    void RecordEndJob(double time, const Job &job);
-    void RecordBeginStep(double time, const Job &job);
-    void RecordEndStep(double time, const Job &job);
-    void RecordBeginGroup(double time, const Job &job);
-    void RecordEndGroup(double time, const Job &job);
-    void RecordBeginCommOp(double time, const Job &job);
-    void RecordEndCommOp(double time, const Job &job);
-    void RecordBeginTransmission(double time, const Job &job);
-    void RecordEndTransmission(double time, const Job &job);
-    void RecordBeginWaiting(double time, const Job &job);
-    void RecordEndWaiting(double time, const Job &job);
+    const TraceFilter &GetFilter() const { return m_Filter; }
+    // Returns whether to record the job while it is in a sharing group of the given number of jobs.
+    bool IsJobTraced(unsigned int jobID, std::size_t groupJobCount) const;
+    // Returns whether to record an event of the kind at the time, given that its job is recorded.
+    bool IsEventTraced(TraceEvent::Kind kind, double time) const {
+        return (m_Filter.KindMask & TraceFilter::GetKindBit(kind)) && time >= m_Filter.StartTime &&
+               time <= m_Filter.EndTime;
+    }
+    // Records the event of the kind at the current position of the job.
+    void Record(TraceEvent::Kind kind, bool isBegin, double time, const Job &job);
 };
-
-extern Tracer Trace;
@@ -0,0 +1,154 @@
+#include "workload.hpp"
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+static std::vector<std::string> SplitCsvLine(const std::string &line) {
+    std::vector<std::string> fields;
+    std::string::size_type begin = 0;
+    while (true) {
+        auto end = line.find(',', begin);
+        fields.push_back(line.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+        if (end == std::string::npos)
+            break;
+        begin = end + 1;
+    }
+    // Trailing carriage returns of files written on Windows
+    if (!fields.back().empty() && fields.back().back() == '\r')
+        fields.back().pop_back();
+    return fields;
+}
+
+static bool EndsWith(const std::string &str, const std::string &suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+WorkloadReader::WorkloadReader(const std::string &path) : m_File(path), m_Path(path) {
+    if (!m_File)
+        throw std::runtime_error("Cannot read workload trace " + path);
+    if (EndsWith(path, ".csv"))
+        m_IsCsv = true;
+    else if (EndsWith(path, ".jsonl"))
+        m_IsCsv = false;
+    else
+        throw std::runtime_error("Unknown format of workload trace " + path);
+    if (!m_IsCsv)
+        return;
+    std::string header;
+    std::getline(m_File, header);
+    ++m_LineNumber;
+    auto columns = SplitCsvLine(header);
+    auto findColumn = [this, &columns](const char *name) {
+        for (unsigned int i = 0; i < columns.size(); ++i)
+            if (columns[i] == name)
+                return i;
+        ThrowError(std::string("missing column ") + name);
+    };
+    m_SubmitTimeColumn = findColumn("submit_time");
+    m_HostCountColumn = findColumn("host_count");
+    m_ModelColumn = findColumn("model");
+    m_StepCountColumn = findColumn("step_count");
+}
+
+void WorkloadReader::ThrowError(const std::string &message) const {
+    throw std::runtime_error("Malformed workload trace " + m_Path + " at line " + std::to_string(m_LineNumber) + ": " +
+                             message);
+}
+
+WorkloadRecord WorkloadReader::ParseCsvLine(const std::string &line) const {
+    auto fields = SplitCsvLine(line);
+    auto getField = [this, &fields](unsigned int column) -> const std::string & {
+        if (column >= fields.size())
+            ThrowError("too few fields");
+        return fields[column];
+    };
+    // std::stoull takes leading spaces and signs, and wraps negative numbers around, so only digits are let through
+    auto getCount = [this, &getField](unsigned int column, const char *name) {
+        const auto &field = getField(column);
+        if (field.empty() || !std::isdigit(static_cast<unsigned char>(field.front())))
+            ThrowError(std::string("invalid ") + name);
+        std::size_t length;
+        auto count = std::stoull(field, &length);
+        if (length != field.size() || count > UINT_MAX)
+            ThrowError(std::string("invalid ") + name);
+        return static_cast<unsigned int>(count);
+    };
+    WorkloadRecord record;
+    try {
+        std::size_t length;
+        record.SubmitTime = std::stod(getField(m_SubmitTimeColumn), &length);
+        if (length != getField(m_SubmitTimeColumn).size())
+            ThrowError("invalid submit_time");
+        record.HostCount = getCount(m_HostCountColumn, "host_count");
+        record.StepCount = getCount(m_StepCountColumn, "step_count");
+    } catch (const std::logic_error &) {
+        // Thrown by the conversions for fields that are not numbers or are out of range
+        ThrowError("invalid number");
+    }
+    record.Model = getField(m_ModelColumn);
+    return record;
+}
+
+WorkloadRecord WorkloadReader::ParseJsonLine(const std::string &line) const {
+    auto json = nlohmann::json::parse(line, nullptr, false);
+    if (json.is_discarded() || !json.is_object())
+        ThrowError("not a JSON object");
+    // get<unsigned int>() would wrap negative numbers around and truncate fractional ones
+    auto getCount = [this, &json](const char *name) {
+        const auto &value = json.at(name);
+        if (!value.is_number_unsigned() || value.get<unsigned long long>() > UINT_MAX)
+            ThrowError(std::string("invalid ") + name);
+        return value.get<unsigned int>();
+    };
+    WorkloadRecord record;
+    try {
+        record.SubmitTime = json.at("submit_time").get<double>();
+        record.HostCount = getCount("host_count");
+        record.Model = json.at("model").get<std::string>();
+        record.StepCount = getCount("step_count");
+    } catch (const nlohmann::json::exception &e) {
+        ThrowError(e.what());
+    }
+    return record;
+}
+
+std::optional<WorkloadRecord> WorkloadReader::ReadNext() {
+    std::string line;
+    while (std::getline(m_File, line)) {
+        ++m_LineNumber;
+        if (line.empty() || line == "\r")
+            continue;
+        auto record = m_IsCsv ? ParseCsvLine(line) : ParseJsonLine(line);
+        // std::stod takes nan and inf, which would pass the order check below
+        if (!std::isfinite(record.SubmitTime) || record.SubmitTime < 0.0)
+            ThrowError("invalid submit_time");
+        if (record.SubmitTime < m_LastSubmitTime)
+            ThrowError("jobs are not sorted by submit time");
+        if (record.HostCount == 0 || record.StepCount == 0)
+            ThrowError("empty job");
+        m_LastSubmitTime = record.SubmitTime;
+        return record;
+    }
+    return std::nullopt;
+}
+
+std::function<std::unique_ptr<Job>()> CreateWorkloadJobSource(const std::string &tracePath,
+                                                              const ModelRegistry &models, double gpuSpeedupRatio) {
+    // Shared by the copies of the source, which std::function requires to be copyable
+    auto reader = std::make_shared<WorkloadReader>(tracePath);
+    return [reader, models, gpuSpeedupRatio]() -> std::unique_ptr<Job> {
+        auto record = reader->ReadNext();
+        if (!record)
+            return nullptr;
+        if (!models.Contains(record->Model, gpuSpeedupRatio))
+            throw std::runtime_error("Unknown model " + record->Model + " in workload trace");
+        if (record->HostCount > models.GetMaxHostCount())
+            throw std::runtime_error("Job of " + std::to_string(record->HostCount) + " hosts in workload trace");
+        auto job = std::make_unique<Job>(record->StepCount,
+                                         models.GetJobModel(record->Model, gpuSpeedupRatio, record->HostCount));
+        job->SetSubmitTime(record->SubmitTime);
+        return job;
+    };
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "data.hpp"
+#include "job.hpp"
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A job submitted in a cluster trace.
+struct WorkloadRecord {
+    double SubmitTime; // In second
+    unsigned int HostCount;
+    std::string Model;
+    unsigned int StepCount;
+};
+
+// Reads the jobs of a cluster trace one at a time, so that memory stays the same however many jobs the trace has. A
+// trace is either a CSV file whose header names the columns submit_time, host_count, model and step_count in any order
+// with no quoted fields, or a JSONL file with an object of the same keys per line, told apart by the extension ".csv"
+// or ".jsonl". Jobs must be sorted by submit time. Throws std::runtime_error with the line number on a malformed trace.
+class WorkloadReader {
+private:
+    std::ifstream m_File;
+    std::string m_Path;
+    bool m_IsCsv;
+    // The position of each column in the CSV header
+    unsigned int m_SubmitTimeColumn;
+    unsigned int m_HostCountColumn;
+    unsigned int m_ModelColumn;
+    unsigned int m_StepCountColumn;
+    unsigned int m_LineNumber = 0;
+    double m_LastSubmitTime = 0.0;
+
+    [[noreturn]] void ThrowError(const std::string &message) const;
+    WorkloadRecord ParseCsvLine(const std::string &line) const;
+    WorkloadRecord ParseJsonLine(const std::string &line) const;
+
+public:
+    explicit WorkloadReader(const std::string &path);
+
+    // Returns the next job, std::nullopt at the end of the trace.
+    std::optional<WorkloadRecord> ReadNext();
+};
+
+// Returns a source of the jobs in the trace for the controller, each submitted at its submit time with the model at
+// the GPU speedup ratio, which must be loaded in the registry. Throws std::runtime_error on a malformed trace or on a
+// job with an unknown model or too many hosts.
+std::function<std::unique_ptr<Job>()> CreateWorkloadJobSource(const std::string &tracePath,
+                                                              const ModelRegistry &models, double gpuSpeedupRatio);